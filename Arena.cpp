@@ -1,120 +1,65 @@
 #include "Arena.h"
 #include "RobotBase.h"
-#include <filesystem>
 #include <algorithm>
 #include <string>
 #include <iostream>
 #include <unistd.h>
-#include <dlfcn.h> // For dynamic library loading
 #include <ostream>
 #include <fstream>
 #include <sstream>
+#include <cmath>
+#include <ctime>
+#include <fcntl.h>
 
 
-// Define the unique characters for robots
-static const char unique_char[] = {
-    '!', '@', '#', '$', '%', '^', '&', '*', '(', ')', '-', '_', '+', '=', '{', '}', '[', ']', '|',
-    ':', ';', '"', '\'', '<', '>', ',', '.', '?', '/', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9'
-};
-
 // Constructor - Set the size of the arena
-Arena::Arena(int row_in, int col_in) 
+Arena::Arena(int row_in, int col_in, std::uint32_t seed) 
+    : m_size_row(row_in), m_size_col(col_in), m_board(row_in, col_in),
+      m_occupant(m_board.cell_count(), -1),
+      m_seed(seed), m_map_random(seed, random_map), m_placement_random(seed, random_placement),
+      m_stray_random(seed, random_damage - 1)
 {
-    m_size_row = row_in;
-    m_size_col = col_in;
-    m_board.resize(m_size_row, std::vector<char>(m_size_col, '.'));
+    build_radar_lanes();
 }
 
 bool Arena::load_robots() 
 {
-    namespace fs = std::filesystem;
     std::cout << "Loading Robots..." << std::endl;
 
-    try 
+    for (const RobotFactory& factory : load_robot_factories(std::cout, std::cerr))
     {
-        // Scan the current directory for Robot_<name>.cpp files
-        for (const auto& entry : fs::directory_iterator(".")) 
+        // Instantiate the robot and add it to the m_robots list
+        RobotBase* robot = factory.create();
+        if (robot) 
         {
-            if (entry.is_regular_file()) 
-            {
-                std::string filename = entry.path().filename().string();
-
-                // Check if the file matches the naming pattern Robot_<name>.cpp
-                if (filename.rfind("Robot_", 0) == 0 && filename.substr(filename.size() - 4) == ".cpp") 
-                {
-                    std::string robot_name = filename.substr(6, filename.size() - 10); // Extract <name>
-                    std::string shared_lib = "lib" + robot_name + ".so";
-
-                    // Compile the file into a shared library
-                    std::string compile_cmd = "g++ -shared -fPIC -o " + shared_lib + " " + filename + " RobotBase.o -I. -std=c++20";
-                    std::cout << "Compiling " << filename << " to " << shared_lib << "...\n";
-
-                    int compile_result = std::system(compile_cmd.c_str());
-                    if (compile_result != 0) 
-                    {
-                        std::cerr << "Failed to compile " << filename << " with command: " << compile_cmd << std::endl;
-                        continue;
-                    }
-
-                    // Load the shared library dynamically
-                    void* handle = dlopen(shared_lib.c_str(), RTLD_LAZY);
-                    if (!handle) 
-                    {
-                        std::cerr << "Failed to load " << shared_lib << ": " << dlerror() << std::endl;
-                        continue;
-                    }
-
-                    // Locate the factory function to create the robot
-                    using RobotFactory = RobotBase* (*)();
-                    RobotFactory create_robot = (RobotFactory)dlsym(handle, "create_robot");
-                    if (!create_robot) 
-                    {
-                        std::cerr << "Failed to find create_robot in " << shared_lib << ": " << dlerror() << std::endl;
-                        dlclose(handle);
-                        continue;
-                    }
-
-                    // Instantiate the robot and add it to the m_robots list
-                    RobotBase* robot = create_robot();
-                    if (robot) 
-                    {
-                        //setup the robot
-                        robot->m_name = robot_name;
-                        robot->set_boundaries(m_size_row,m_size_col);
-                        std::cout << "boundaries: " << m_size_row << ", " << m_size_col << std::endl;
- 
-                        // Find a random valid position for the robot
-                        int row, col;
-                        do 
-                        {
-                            row = std::rand() % m_size_row;
-                            col = std::rand() % m_size_col;
-                        } while (m_board[row][col] != '.'); // Ensure it's an empty spot
-
-                        robot->move_to(row, col);
-                        m_board[row][col] = 'R'; // Mark the robot's position on the board
-                        m_robots.push_back(robot);
-
-                        std::cout << "Loaded robot: " << robot_name << " at (" << row << ", " << col << ")\n";
-                    } 
-                    else 
-                    {
-                        std::cerr << "Failed to create robot from " << shared_lib << std::endl;
-                        dlclose(handle);
-                    }
-                }
-            }
+            std::cout << "boundaries: " << m_size_row << ", " << m_size_col << std::endl;
+            int row, col;
+            place_robot(robot, factory.name, row, col);
+            std::cout << "Loaded robot: " << factory.name << " at (" << row << ", " << col << ")\n";
+        } 
+        else 
+        {
+            std::cerr << "Failed to create robot from lib" << factory.name << ".so" << std::endl;
         }
-    } 
-    catch (const fs::filesystem_error& e) 
-    {
-        std::cerr << "Filesystem error: " << e.what() << std::endl;
-        return false;
     }
 
     return !m_robots.empty(); // Return true if at least one robot was loaded
 }
 
+// set the robot up and put it on a random empty cell
+void Arena::place_robot(RobotBase* robot, const std::string& name, int& row, int& col)
+{
+    robot->m_name = name;
+    robot->set_boundaries(m_size_row,m_size_col);
+    do 
+    {
+        row = m_placement_random.below(m_size_row);
+        col = m_placement_random.below(m_size_col);
+    } while (m_board.get(row, col) != '.'); // Ensure it's an empty spot
+
+    add_robot(robot, row, col);
+}
+
 
 // Given the robot's preference on radar direction, get radar results
 void Arena::get_radar_results(RobotBase* robot, int radar_direction, std::vector<RadarObj>& radar_results) 
@@ -136,39 +81,29 @@ void Arena::get_radar_local(RobotBase* robot, std::vector<RadarObj>& radar_resul
 {
     int current_row, current_col;
     robot->get_current_location(current_row, current_col);
+    int center = m_board.index(current_row, current_col);
 
-    // Perform a 3x3 scan around the robot
+    // Perform a 3x3 scan around the robot, one 3 bit slice of layer_any per row.
+    // Cells off the edge are border walls, which are never in the layer.
     for (int row_offset = -1; row_offset <= 1; ++row_offset) 
     {
-        for (int col_offset = -1; col_offset <= 1; ++col_offset) 
+        std::uint64_t seen = m_board.bits(layer_any, center + row_offset * m_board.stride() - 1, 3);
+
+        // Skip the robot's own location
+        if (row_offset == 0)
         {
-            // Skip the robot's own location
-            if (row_offset == 0 && col_offset == 0) 
-            {
-                continue;
-            }
+            seen &= ~std::uint64_t(2);
+        }
 
+        for (; seen != 0; seen &= seen - 1)
+        {
+            int col_offset = std::countr_zero(seen) - 1;
             int scan_row = current_row + row_offset;
             int scan_col = current_col + col_offset;
 
-            // Skip out-of-bounds locations
-            if (scan_row < 0 || scan_row >= m_size_row || scan_col < 0 || scan_col >= m_size_col) 
-            {
-                continue;
-            }
-
-            // Get the cell content
-            char cell = m_board[scan_row][scan_col];
-
-            // Skip empty cells
-            if (cell == '.') 
-            {
-                continue;
-            }
-
             // Record the radar object
             RadarObj radar_obj;
-            radar_obj.m_type = cell;
+            radar_obj.m_type = m_board.get(scan_row, scan_col);
             radar_obj.m_row = scan_row;
             radar_obj.m_col = scan_col;
             radar_results.push_back(radar_obj);
@@ -176,116 +111,180 @@ void Arena::get_radar_local(RobotBase* robot, std::vector<RadarObj>& radar_resul
     }
 }
 
-void Arena::scan_location(int row, int col, std::vector<RadarObj>& radar_results)
+// Work out the lanes every radar beam covers. A beam is the middle cell plus one cell on
+// either side, for each step away from the robot. Diagonal beams also pick up the two
+// 'holes' between their steps. Every one of those is a line parallel to the beam, so each
+// lane is a run of bits in the rotated layer_any that runs the same way as the beam.
+void Arena::build_radar_lanes()
 {
-    if (row >= 0 && row < m_size_row && col >= 0 && col < m_size_col) 
+    for (int radar_direction = 1; radar_direction <= 8; ++radar_direction)
+    {
+        const auto [delta_row, delta_col] = directions[radar_direction];
+        RadarLanes& lanes = m_radar_lanes[radar_direction];
+
+        if (delta_row == 0)
+            lanes.orientation = Board::by_row;
+        else if (delta_col == 0)
+            lanes.orientation = Board::by_col;
+        else if (delta_row == delta_col)
+            lanes.orientation = Board::by_diag;
+        else
+            lanes.orientation = Board::by_anti;
+
+        // by_row numbers cells left to right, the rotated ones top to bottom
+        lanes.forward = (lanes.orientation == Board::by_row) ? delta_col > 0 : delta_row > 0;
+
+        // middle of the beam, the +1 and -1 perpendicular cells, then the diagonal holes
+        lanes.count = 0;
+        auto add_lane = [&lanes](int d_row, int d_col)
         {
-            char cell = m_board[row][col];
-            if (cell != '.')
-                radar_results.push_back(RadarObj(cell, row, col));
+            lanes.d_row[lanes.count] = d_row;
+            lanes.d_col[lanes.count] = d_col;
+            ++lanes.count;
+        };
+        add_lane(0, 0);
+        add_lane(delta_col, -delta_row);
+        add_lane(-delta_col, delta_row);
+        if (delta_row != 0 && delta_col != 0)
+        {
+            add_lane(0, delta_row);
+            add_lane(delta_col, 0);
         }
+    }
 }
 
+// bit i of a 'count' bit run moves to bit count-1-i
+static std::uint64_t reverse_bits(std::uint64_t bits, int count)
+{
+    bits = ((bits >> 1) & 0x5555555555555555ull) | ((bits & 0x5555555555555555ull) << 1);
+    bits = ((bits >> 2) & 0x3333333333333333ull) | ((bits & 0x3333333333333333ull) << 2);
+    bits = ((bits >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((bits & 0x0F0F0F0F0F0F0F0Full) << 4);
+    bits = ((bits >> 8) & 0x00FF00FF00FF00FFull) | ((bits & 0x00FF00FF00FF00FFull) << 8);
+    bits = ((bits >> 16) & 0x0000FFFF0000FFFFull) | ((bits & 0x0000FFFF0000FFFFull) << 16);
+    bits = (bits >> 32) | (bits << 32);
+    return bits >> (64 - count);
+}
 
 void Arena::get_radar_ray(RobotBase* robot, int radar_direction, std::vector<RadarObj>& radar_results) 
 {
-    //some setup stuff
-    static const std::set<int> diagonal_directions = {2, 4, 6, 8};
     const auto [delta_row, delta_col] = directions[radar_direction];
+    const RadarLanes& lanes = m_radar_lanes[radar_direction];
     int current_row, current_col;
 
     robot->get_current_location(current_row, current_col);
 
-    int scan_row = current_row + delta_row;
-    int scan_col = current_col + delta_col;
-
     radar_results.clear();
 
-    // look at each location from the start location to the edge of the arena
-    while (scan_row < m_size_row && scan_row >= 0 && scan_col < m_size_col && scan_col >= 0) 
+    // how many steps the middle of the beam can go before it leaves the arena
+    int steps = std::max(m_size_row, m_size_col);
+    if (delta_row > 0) steps = std::min(steps, m_size_row - 1 - current_row);
+    if (delta_row < 0) steps = std::min(steps, current_row);
+    if (delta_col > 0) steps = std::min(steps, m_size_col - 1 - current_col);
+    if (delta_col < 0) steps = std::min(steps, current_col);
+
+    // Up to 64 steps at a time: pull each lane's bits out of the layer with step 'first'
+    // in bit 0, then visit the steps that have anything on them nearest first, lanes in
+    // scan order. The side lanes can be one off the edge, those are walls (never set).
+    for (int first = 1; first <= steps; first += 64)
     {
-        // Scan the middle beam
-        scan_location(scan_row,scan_col, radar_results);
-
-        // Scan the +1 perpendicular cell
-        int extra_row = scan_row + delta_col;
-        int extra_col = scan_col - delta_row;
-        scan_location(extra_row, extra_col, radar_results);
+        const int count = std::min(64, steps - first + 1);
+        std::uint64_t lane_bits[5];
+        std::uint64_t any_lane = 0;
 
-        // Scan the -1 perpendicular cell
-        extra_row = scan_row - delta_col;
-        extra_col = scan_col + delta_row;
-        scan_location(extra_row,extra_col,radar_results);
-
-        // if diagonal, we also need to get the hole. 
-        if(diagonal_directions.count(radar_direction))
+        for (int lane = 0; lane < lanes.count; ++lane)
         {
-            //same row, diff column
-            extra_row = scan_row;
-            extra_col = scan_col + delta_row;
-            scan_location(extra_row,extra_col,radar_results);
+            int row = current_row + lanes.d_row[lane] + first * delta_row;
+            int col = current_col + lanes.d_col[lane] + first * delta_col;
+            if (lanes.forward)
+            {
+                lane_bits[lane] = m_board.any_bits(lanes.orientation, m_board.oriented_index(lanes.orientation, row, col), count);
+            }
+            else
+            {
+                // the layer runs the other way, so start from the far end and flip
+                int far = m_board.oriented_index(lanes.orientation, row + (count - 1) * delta_row, col + (count - 1) * delta_col);
+                lane_bits[lane] = reverse_bits(m_board.any_bits(lanes.orientation, far, count), count);
+            }
+            any_lane |= lane_bits[lane];
+        }
 
-            //same col, diff row
-            extra_row = scan_row + delta_col;
-            extra_col = scan_col;
-            scan_location(extra_row,extra_col,radar_results);
+        for (; any_lane != 0; any_lane &= any_lane - 1)
+        {
+            int bit = std::countr_zero(any_lane);
+            int step = first + bit;
+            for (int lane = 0; lane < lanes.count; ++lane)
+            {
+                if ((lane_bits[lane] >> bit) & 1)
+                {
+                    int row = current_row + lanes.d_row[lane] + step * delta_row;
+                    int col = current_col + lanes.d_col[lane] + step * delta_col;
+                    radar_results.push_back(RadarObj(m_board.get(row, col), row, col));
+                }
+            }
         }
-        
-        // Move the beam forward
-        scan_row += delta_row;
-        scan_col += delta_col;
     }
 }
 
 // Handle the robot's shot
-std::string Arena::handle_shot(RobotBase* robot, int shot_row, int shot_col) 
+void Arena::handle_shot(RobotBase* robot, int shot_row, int shot_col) 
 {
-    std::stringstream ss;
-
     WeaponType weapon = robot->get_weapon();
+    add_event(TurnEventType::shot, robot).detail = static_cast<char>(weapon);
     switch (weapon) 
     {
         case flamethrower:
-            ss << " firing flamethrower... ";
-            ss << handle_flame_shot(robot, shot_row, shot_col);
+            handle_flame_shot(robot, shot_row, shot_col);
             break;
 
         case railgun:
-            ss << " shooting railgun... ";
-            ss << handle_railgun_shot(robot, shot_row, shot_col);
+            handle_railgun_shot(robot, shot_row, shot_col);
             break;
 
         case grenade:
-            ss << " launching grenade... ";
-            ss << handle_grenade_shot(robot, shot_row, shot_col);
+            handle_grenade_shot(robot, shot_row, shot_col);
             break;
 
         case hammer:
-            ss << " pounding with the hammer...";
-            ss <<  handle_hammer_shot(robot, shot_row, shot_col);
+            handle_hammer_shot(robot, shot_row, shot_col);
             break;
 
         default:
-            return "strange weapon? ";
-
+            break;   // strange weapon? nothing happens
     }
-    return ss.str();
 }
-std::string Arena::apply_damage_to_robot(RobotBase* robot, WeaponType weapon)
+void Arena::apply_damage_to_robot(RobotBase* robot, WeaponType weapon)
+{
+    apply_damage_to_robot(robot, weapon, damage_random(robot));
+}
+
+void Arena::apply_damage_to_robot(RobotBase* robot, WeaponType weapon, RandomStream& random)
 {
-    std::stringstream ss;
     int armor = robot->get_armor();
-    int damage = calculate_damage(weapon,armor);
+    int damage = calculate_damage(weapon,armor,random);
 
-    robot->take_damage(damage);
+    int health = robot->take_damage(damage);
     robot->reduce_armor(1);
 
-    ss << robot->m_name << " takes " << damage << " damage. Health: " << robot->get_health() << std::endl;
-    return ss.str();
+    TurnEvent& hit = add_event(TurnEventType::hit, robot);
+    hit.amount = static_cast<std::int16_t>(damage);
+    hit.health = static_cast<std::int16_t>(health);
+}
 
+// same thing for a robot in the arena, by index, so its copy in m_state keeps up
+void Arena::apply_damage_to_robot(int slot, WeaponType weapon)
+{
+    apply_damage_to_robot(m_robots[slot], weapon, m_damage_random[slot]);
+    sync_robot(slot);
 }
 
-int Arena::calculate_damage(WeaponType weapon, int armor_level) 
+// the stream a robot's damage rolls come from, when all there is to go on is the pointer
+RandomStream& Arena::damage_random(const RobotBase* robot)
+{
+    auto found = std::find(m_robots.begin(), m_robots.end(), robot);
+    return found == m_robots.end() ? m_stray_random : m_damage_random[found - m_robots.begin()];
+}
+
+int Arena::calculate_damage(WeaponType weapon, int armor_level, RandomStream& random) 
 {
     int min_damage = 0, max_damage = 0;
     switch (weapon) {
@@ -310,7 +309,7 @@ int Arena::calculate_damage(WeaponType weapon, int armor_level)
     }
 
     // Generate random damage within the range
-    int base_damage = min_damage + (std::rand() % (max_damage - min_damage + 1));
+    int base_damage = min_damage + random.below(max_damage - min_damage + 1);
 
     // Apply armor reduction (10% per armor level, max 40%)
     double armor_multiplier = 1.0 - (0.1 * std::min(armor_level, 4));
@@ -320,189 +319,235 @@ int Arena::calculate_damage(WeaponType weapon, int armor_level)
 }
 
 
-std::string Arena::handle_flame_shot(RobotBase* robot, int shot_row, int shot_col)
-{
-    std::stringstream ss;
+// The flame cone only depends on where a robot aims relative to itself, so every possible
+// cone is worked out once and kept in a table. A cone always fits in the 9x9 box around the
+// robot - each row of the box is a bit mask, bit 0 is 4 columns left of the robot.
+static const int flame_range = 4;
+static const int flame_box = 2 * flame_range + 1;
 
-    // Get the current location of the robot
-    int current_row, current_col;
-    robot->get_current_location(current_row, current_col);
+// Past this the very first step of the flame is out of range, so the cone is empty.
+static const int flame_aim_limit = 18;
 
-    // Calculate directional increments for the flame path
-    int delta_row = shot_row - current_row;
-    int delta_col = shot_col - current_col;
+struct FlameStencil
+{
+    int steps = 0;                           // steps before the flame runs out of range
+    int main_row[flame_range + 1] = {};      // middle of the flame at each step, relative to the robot
+    int main_col[flame_range + 1] = {};
+    std::uint16_t reach[flame_range + 1][flame_box] = {};  // cells burned if the first k steps are on the board
+};
 
-    int steps = 4; // Flame extends 4 cells from the robot's current location
-    double slope_row = static_cast<double>(delta_row) / steps;
-    double slope_col = static_cast<double>(delta_col) / steps;
+static int floor_div(int num, int den)
+{
+    return (num >= 0) ? num / den : -((-num + den - 1) / den);
+}
 
-    // Collect all cells affected by the flame
-    std::vector<RadarObj> flame_cells;
+// The flame goes 4 steps towards the aim point, a quarter of the way each step, rounded to
+// the nearest cell. Each step lights the middle cell and spreads one cell either way (if the
+// robot aims straight along a row or column), but nothing further than 4 from the robot.
+static FlameStencil build_flame_stencil(int delta_row, int delta_col)
+{
+    FlameStencil stencil;
+    std::uint16_t cells[flame_box] = {};
 
-    auto cell_exists = [&flame_cells](int row, int col) {
-        return std::any_of(flame_cells.begin(), flame_cells.end(), [row, col](const RadarObj& obj) {
-            return obj.m_row == row && obj.m_col == col;
-        });
-    };
+    const int spread_row = (delta_col != 0 ? 0 : 1);
+    const int spread_col = (delta_row != 0 ? 0 : 1);
 
-    double r = current_row;
-    double c = current_col;
+    auto in_range = [](int row, int col) { return row * row + col * col <= flame_range * flame_range; };
+    auto burn = [&cells](int row, int col) { cells[row + flame_range] |= 1 << (col + flame_range); };
 
-    for (int step = 1; step <= steps; ++step)
+    for (int step = 1; step <= flame_range; ++step)
     {
-        // Advance the flame ray
-        r += slope_row;
-        c += slope_col;
-
-        int path_row = static_cast<int>(std::round(r));
-        int path_col = static_cast<int>(std::round(c));
-
-        // Boundary checks for the main flame path
-        if (path_row < 0 || path_row >= m_size_row || path_col < 0 || path_col >= m_size_col)
-        {
-            break; // Stop if out of bounds
-        }
+        // step/4 of the way there, halves round up
+        int row = floor_div(step * delta_row + 2, 4);
+        int col = floor_div(step * delta_col + 2, 4);
 
-        // Calculate Euclidean distance from the robot
-        double distance = std::sqrt(std::pow(path_row - current_row, 2) + std::pow(path_col - current_col, 2));
-        if (distance > 4.0)
+        if (!in_range(row, col))
         {
-            break; // Stop if the cell is beyond the flame's range
+            break;
         }
 
-        // Skip adding the shooter’s current location to the flame path
-        if (path_row == current_row && path_col == current_col)
-        {
-            continue;
-        }
+        stencil.main_row[step] = row;
+        stencil.main_col[step] = col;
 
-        // Add the main flame cell to the path if not already present
-        if (!cell_exists(path_row, path_col))
+        // the shooter's own cell doesn't burn, and neither does its spread
+        if (row != 0 || col != 0)
         {
-            flame_cells.emplace_back('F', path_row, path_col);
-        }
-
-        // Add adjacent cells for the 3-cell wide flame
-        for (int offset = -1; offset <= 1; ++offset)
-        {
-            int adj_row = path_row + offset * (delta_col != 0 ? 0 : 1); // Vertical spread if horizontal movement
-            int adj_col = path_col + offset * (delta_row != 0 ? 0 : 1); // Horizontal spread if vertical movement
-
-            // Boundary checks for adjacent cells
-            if (adj_row >= 0 && adj_row < m_size_row && adj_col >= 0 && adj_col < m_size_col)
+            burn(row, col);
+            for (int offset = -1; offset <= 1; ++offset)
             {
-                // Calculate distance for the adjacent cell
-                double adj_distance = std::sqrt(std::pow(adj_row - current_row, 2) + std::pow(adj_col - current_col, 2));
-                if (adj_distance <= 4.0 && !cell_exists(adj_row, adj_col))
+                int adj_row = row + offset * spread_row;
+                int adj_col = col + offset * spread_col;
+                if (in_range(adj_row, adj_col))
                 {
-                    flame_cells.emplace_back('F', adj_row, adj_col);
+                    burn(adj_row, adj_col);
                 }
             }
         }
-    }
 
-    // Apply damage to robots in the flame path
-    for (auto* target_robot : m_robots)
-    {
-        int target_row, target_col;
-        target_robot->get_current_location(target_row, target_col);
+        std::copy(cells, cells + flame_box, stencil.reach[step]);
+        stencil.steps = step;
+    }
 
-        // Check if the robot's location matches any cell in the flame path
-        for (const RadarObj& flame_cell : flame_cells)
-        {
-            if (flame_cell.m_row == target_row && flame_cell.m_col == target_col)
-            {
-                // Skip applying damage to the shooter
-                if (target_robot == robot)
-                {
-                    continue;
-                }
+    return stencil;
+}
 
-                ss << apply_damage_to_robot(target_robot, flamethrower);
-                break; // No need to check further flame cells for this robot
-            }
-        }
+static const FlameStencil& flame_stencil(int delta_row, int delta_col)
+{
+    static const int width = 2 * flame_aim_limit + 1;
+    static const std::vector<FlameStencil> table = [] {
+        std::vector<FlameStencil> stencils;
+        for (int delta_row = -flame_aim_limit; delta_row <= flame_aim_limit; ++delta_row)
+            for (int delta_col = -flame_aim_limit; delta_col <= flame_aim_limit; ++delta_col)
+                stencils.push_back(build_flame_stencil(delta_row, delta_col));
+        return stencils;
+    }();
+    static const FlameStencil empty;
+
+    if (std::abs(delta_row) > flame_aim_limit || std::abs(delta_col) > flame_aim_limit)
+    {
+        return empty;
     }
-    return ss.str();
+    return table[(delta_row + flame_aim_limit) * width + (delta_col + flame_aim_limit)];
 }
 
-std::string Arena::handle_railgun_shot(RobotBase* robot, int shot_row, int shot_col) 
+void Arena::handle_flame_shot(RobotBase* robot, int shot_row, int shot_col)
 {
-    std::stringstream ss;
+    // Get the current location of the robot
     int current_row, current_col;
     robot->get_current_location(current_row, current_col);
 
-    // Calculate directional increments for the ray
     int delta_row = shot_row - current_row;
     int delta_col = shot_col - current_col;
+    const FlameStencil& stencil = flame_stencil(delta_row, delta_col);
+
+    // The flame stops at the first step that leaves the arena. A step exactly half a cell
+    // off the top or left edge rounds away from zero, which is off the board too.
+    int steps = 0;
+    for (int step = 1; step <= stencil.steps; ++step)
+    {
+        int path_row = current_row + stencil.main_row[step];
+        int path_col = current_col + stencil.main_col[step];
+        bool half_off = (path_row == 0 && 4 * current_row + step * delta_row == -2) ||
+                        (path_col == 0 && 4 * current_col + step * delta_col == -2);
 
-    // Normalize the direction to unit increments (step in a straight line)
-    int steps = std::max(std::abs(delta_row), std::abs(delta_col));
-    if (steps == 0) {
-        ss << "Invalid shot direction.";
-        return ss.str();
+        if (!m_board.in_bounds(path_row, path_col) || half_off)
+        {
+            break;
+        }
+        steps = step;
     }
+    const std::uint16_t* flame = stencil.reach[steps];
 
-    double step_row = static_cast<double>(delta_row) / steps;
-    double step_col = static_cast<double>(delta_col) / steps;
+    // Apply damage to robots in the flame path
+    for (int box_row = 0; box_row < flame_box; ++box_row)
+    {
+        robots_in_row_mask(current_row - flame_range + box_row, current_col - flame_range, flame[box_row], [&](int slot) {
+            // Skip applying damage to the shooter
+            if (m_robots[slot] != robot)
+            {
+                apply_damage_to_robot(slot, flamethrower);
+            }
+        });
+    }
+}
 
-    // Traverse the path
-    double r = current_row + step_row;
-    double c = current_col + step_col;
-    std::vector<RobotBase*> target_list;
+// Follow a railgun shot from (from_row, from_col) through (shot_row, shot_col) to the edge
+// of the arena and put the index of every live robot on the way into 'hits', nearest first.
+//
+// The ray takes max(|delta_row|, |delta_col|) steps to reach the shot location, and at each
+// step a row and column are the exact position rounded to the nearest cell (halves round
+// away from zero, like std::round). It's all done with integers, Bresenham style: 'pos' is
+// the rounded cell and 'rem' is what is left over, in units of 1/(2*steps) of a cell, so
+// every compiler and -O level gets exactly the same cells.
+void Arena::trace_railgun(int from_row, int from_col, int shot_row, int shot_col, std::vector<int>& hits) const
+{
+    hits.clear();
 
-    while (true) {
-        int path_row = static_cast<int>(std::round(r));
-        int path_col = static_cast<int>(std::round(c));
+    const int delta_row = shot_row - from_row;
+    const int delta_col = shot_col - from_col;
+    const int steps = std::max(std::abs(delta_row), std::abs(delta_col));
+    if (steps == 0)
+    {
+        return;
+    }
 
-        // Check if out of bounds
-        if (path_row < 0 || path_row >= m_size_row || path_col < 0 || path_col >= m_size_col) {
+    const int unit = 2 * steps;
+    int row = from_row, row_rem = steps;   // starting at from + 1/2, so floor() rounds
+    int col = from_col, col_rem = steps;
+    int index = m_board.index(row, col);
+
+    // one DDA step along one axis. Moves at most one cell since |delta| <= steps.
+    auto advance = [unit](int& pos, int& rem, int delta) {
+        rem += 2 * delta;
+        if (rem >= unit) { rem -= unit; return ++pos, 1; }
+        if (rem < 0)     { rem += unit; return --pos, -1; }
+        return 0;
+    };
+
+    while (true)
+    {
+        index += advance(row, row_rem, delta_row) * m_board.stride();
+        index += advance(col, col_rem, delta_col);
+
+        // exactly -0.5 rounds away from zero to -1, which is off the board
+        if ((row == 0 && row_rem == 0) || (col == 0 && col_rem == 0))
+        {
             break;
         }
 
-        char cell = m_board[path_row][path_col];
-
-        // Check for robots (exclude the shooting robot itself)
-        if (cell == 'R') {
-            for (RobotBase* target_robot : m_robots) {
-                int target_row, target_col;
-                target_robot->get_current_location(target_row, target_col);
+        // The ray moves at most one cell per step, so it always stops on the border wall
+        if (m_board.at(index) == Board::wall)
+        {
+            break;
+        }
 
-                if (target_row == path_row && target_col == path_col && target_robot != robot) 
-                {
-                    target_list.push_back(target_robot);
-                }
-            }
+        int slot = robot_at_index(index);
+        if (slot != -1)
+        {
+            hits.push_back(slot);
         }
+    }
+}
+
+void Arena::handle_railgun_shot(RobotBase* robot, int shot_row, int shot_col) 
+{
+    int current_row, current_col;
+    robot->get_current_location(current_row, current_col);
 
-        // Move to the next step along the ray
-        r += step_row;
-        c += step_col;
+    if (shot_row == current_row && shot_col == current_col) {
+        add_event(TurnEventType::railgun_invalid, robot);
+        return;
     }
 
-    // Apply damage to all robots in the target list
-    if (!target_list.empty()) {
-        for (RobotBase* target_robot : target_list) {
-            ss << apply_damage_to_robot(target_robot, railgun) << "  ";
+    std::vector<int> hits;
+    trace_railgun(current_row, current_col, shot_row, shot_col, hits);
+
+    // Apply damage to everything the ray went through (except the shooting robot itself)
+    bool hit_something = false;
+    for (int slot : hits) {
+        if (m_robots[slot] != robot) {
+            apply_damage_to_robot(slot, railgun);
+            hit_something = true;
         }
-    } else {
-        ss << " railgun missed!  The universe is upside down! ";
     }
 
-    return ss.str();
-
+    if (!hit_something) {
+        add_event(TurnEventType::railgun_miss, robot);
+    }
 }
 
 
-std::string Arena::handle_grenade_shot(RobotBase* robot, int shot_row, int shot_col) 
+void Arena::handle_grenade_shot(RobotBase* robot, int shot_row, int shot_col) 
 {
-    std::stringstream ss;
     int current_row, current_col;
     robot->get_current_location(current_row, current_col);
 
     // reduce the number of grenades...
     if(robot->get_grenades() <=0 )
-        return " out of grenades. ";    
+    {
+        add_event(TurnEventType::no_grenades, robot);
+        return;
+    }
         
     robot->decrement_grenades();
 
@@ -519,52 +564,15 @@ std::string Arena::handle_grenade_shot(RobotBase* robot, int shot_row, int shot_
         shot_col = current_col + static_cast<int>(delta_col * scaling_factor);
     }
 
-    // Generate a 5x5 grid of cells around the target location
-    std::vector<std::pair<int, int>> explosion_cells;
-    for (int r = shot_row - 2; r <= shot_row + 2; ++r) 
-    {
-        for (int c = shot_col - 2; c <= shot_col + 2; ++c) 
-        {
-            // Ensure the cell is within arena boundaries
-            if (r >= 0 && r < m_size_row && c >= 0 && c < m_size_col) 
-            {
-                explosion_cells.emplace_back(r, c);
-            }
-        }
-    }
-
-
-    // Check each cell for robots
-    for (const auto& cell : explosion_cells) 
-    {
-        int cell_row = cell.first;
-        int cell_col = cell.second;
-
-        if (m_board[cell_row][cell_col] == 'R') // Check if there is a robot in the cell
-        {
-            // Match the cell to a robot in m_robots
-            for (auto* target : m_robots) 
-            {
-                int target_row, target_col;
-                target->get_current_location(target_row, target_col);
-
-                if (target_row == cell_row && target_col == cell_col) 
-                {
-                    // Apply grenade damage to the robot
-                    ss << apply_damage_to_robot(target, grenade) << " ";
-                    break; // No need to check further robots for this cell
-                }
-            }
-        }
-    }
-
-    return ss.str();
+    // Everything in the 5x5 square around the target location takes damage
+    robots_in_rect(shot_row - 2, shot_col - 2, shot_row + 2, shot_col + 2, [&](int slot) {
+        apply_damage_to_robot(slot, grenade);
+    });
 }
 
 
-std::string Arena::handle_hammer_shot(RobotBase* robot, int shot_row, int shot_col) 
+void Arena::handle_hammer_shot(RobotBase* robot, int shot_row, int shot_col) 
 {
-    std::stringstream ss;
     int current_row, current_col;
     robot->get_current_location(current_row, current_col);
 
@@ -581,39 +589,32 @@ std::string Arena::handle_hammer_shot(RobotBase* robot, int shot_row, int shot_c
     target_col = std::clamp(target_col, 0, m_size_col - 1);
 
     // Check if there's a robot in the calculated target cell
-    if (m_board[target_row][target_col] == 'R') 
+    int slot = robot_at(target_row, target_col);
+    if (slot != -1) 
     {
-        // Find the robot in the list and apply damage
-        for (auto* target : m_robots) 
-        {
-            int target_row_robot, target_col_robot;
-            target->get_current_location(target_row_robot, target_col_robot);
-
-            if (target_row_robot == target_row && target_col_robot == target_col) 
-            {
-                ss << apply_damage_to_robot(target, hammer);
-                return ss.str();
-            }
-        }
+        apply_damage_to_robot(slot, hammer);
+        return;
     }
 
-    ss << robot->m_name << " hammer missed trying to hit (" << target_row << "," << target_col << ") ";
-    return ss.str();
+    TurnEvent& miss = add_event(TurnEventType::hammer_miss, robot);
+    miss.row = static_cast<std::int16_t>(target_row);
+    miss.col = static_cast<std::int16_t>(target_col);
 }
 
 
 
-std::string Arena::handle_move(RobotBase* robot) 
+void Arena::handle_move(RobotBase* robot) 
 {
-    std::stringstream ss;
     int move_direction;
     int move_distance;
 
+    add_event(TurnEventType::move, robot);
+
     // Check if the robot cannot move
     if (robot->get_move() == 0)
     {
-        ss << robot->m_name << " cannot move. ";
-        return ss.str();
+        add_event(TurnEventType::cannot_move, robot);
+        return;
     }
 
     // Get the direction and distance desired from the robot
@@ -623,8 +624,8 @@ std::string Arena::handle_move(RobotBase* robot)
     // Check if no movement is requested
     if (move_direction < 1 || move_direction > 8  || move_distance == 0)
     {
-        ss << robot->m_name << " chooses not to move.";
-        return ss.str();
+        add_event(TurnEventType::no_move, robot);
+        return;
     }
 
     int current_row, current_col;
@@ -634,95 +635,135 @@ std::string Arena::handle_move(RobotBase* robot)
     int delta_row = directions[move_direction].first;
     int delta_col = directions[move_direction].second;
 
-    // Loop through each step of the intended movement
-    for (int step = 1; step <= move_distance; ++step)
+    // The board knows how far the robot can get before something is in the way, so go
+    // straight there. Only when the way is blocked do we look at the next cell.
+    for (int steps_left = move_distance; steps_left > 0; )
     {
-        // Calculate the next cell - make sure it is in the arena.
-        int next_row = std::clamp(current_row + delta_row, 0, m_size_row - 1);
-        int next_col = std::clamp(current_col + delta_col, 0, m_size_col - 1);
-        char cell = m_board[next_row][next_col];
+        int run = std::min(m_board.free_run(m_board.index(current_row, current_col), move_direction), steps_left);
+        int next_row = current_row + delta_row * std::max(run, 1);
+        int next_col = current_col + delta_col * std::max(run, 1);
 
-        // Check for obstacles or collisions
-        if (cell != '.')
+        if (run == 0)
         {
-            ss << handle_collision(robot, cell, next_row, next_col);
-            return ss.str();
+            char cell = m_board.get(next_row, next_col);
+
+            // At the edge, clamp back into the arena. That lets a diagonal move slide along the wall.
+            if (cell == Board::wall)
+            {
+                next_row = std::clamp(next_row, 0, m_size_row - 1);
+                next_col = std::clamp(next_col, 0, m_size_col - 1);
+                cell = m_board.get(next_row, next_col);
+            }
+
+            // Check for obstacles or collisions
+            if (cell != '.')
+            {
+                handle_collision(robot, cell, next_row, next_col);
+                return;
+            }
+            run = 1;
         }
 
-        // Move the robot to the next cell
-        m_board[current_row][current_col] = '.'; // Clear the current cell
+        // Move the robot, and take its slot in m_occupant along with it
+        int from = m_board.index(current_row, current_col);
+        int to = m_board.index(next_row, next_col);
+        m_board.set_at(from, '.'); // Clear the current cell
         robot->move_to(next_row, next_col);
-        m_board[next_row][next_col] = 'R'; // Mark the new position
+        m_board.set_at(to, 'R'); // Mark the new position
+        m_occupant[to] = m_occupant[from];
+        m_occupant[from] = -1;
         current_row = next_row;
         current_col = next_col;
+        steps_left -= run;
     }
 
-    ss << robot->m_name << " moves to (" << current_row << "," << current_col << ") ";
-    return ss.str();
+    TurnEvent& moved = add_event(TurnEventType::moved, robot);
+    moved.row = static_cast<std::int16_t>(current_row);
+    moved.col = static_cast<std::int16_t>(current_col);
 }
 
 
 
+// How far a robot could move in a direction right now before it runs into something,
+// capped at its move speed.
+int Arena::max_reachable(RobotBase* robot, int move_direction) const
+{
+    if (move_direction < 1 || move_direction > 8)
+    {
+        return 0;
+    }
+    int current_row, current_col;
+    robot->get_current_location(current_row, current_col);
+    return std::min(m_board.free_run(m_board.index(current_row, current_col), move_direction), robot->get_move());
+}
+
 // Handle collisions or interactions with obstacles
-std::string Arena::handle_collision(RobotBase* robot, char cell, int row, int col) 
+void Arena::handle_collision(RobotBase* robot, char cell, int row, int col) 
 {
-    std::stringstream ss;
+    TurnEvent& collision = add_event(TurnEventType::collision, robot);
+    collision.detail = cell;
+    collision.row = static_cast<std::int16_t>(row);
+    collision.col = static_cast<std::int16_t>(col);
 
     switch (cell) 
     {
-        case 'M': // Mound
-            ss << robot->m_name << " is stopped by a mound at (" << row << "," << col << "). " << std::endl;
-            break;
-
-        case 'X': // Dead Robot
-            ss << robot->m_name << " is stopped by a dead robot at (" << row << "," << col << "). " << std::endl;
-            break;
-
-        case 'R': // Another robot
-            ss << robot->m_name << " crashes into another robot at ("  << row << "," << col << "). " << std::endl;
-            break;
-
         case 'P': // Pit
             robot->disable_movement();
-            ss << robot->m_name << " is stuck in a pit at (" << row << "," << col << "). Movement disabled. " << std::endl;
             break;
 
         case 'F': // Flamethrower
-            ss << robot->m_name << " encounters a flamethrower at ("  << row << "," << col << "). Taking damage! " << std::endl;
-            ss << apply_damage_to_robot(robot, flamethrower); // Apply flamethrower damage
+            apply_damage_to_robot(robot, flamethrower); // Apply flamethrower damage
             break;
 
-        default:
-            ss << "Unknown obstacle: " << cell << " at (" << row << "," << col << ")." << std::endl;
+        default:  // Mounds, dead robots and other robots just stop it
             break;
     }
+}
 
-    return ss.str();
+// Start a new event record in m_events. Everything but the type and robot starts out 0.
+TurnEvent& Arena::add_event(TurnEventType type, const RobotBase* robot)
+{
+    TurnEvent& event = m_events.emplace_back();
+    event = TurnEvent{};
+    event.type = type;
+    event.robot = robot;
+    return event;
 }
 
 
 
+// Obstacle types to place
+static const char obstacle_kinds[] = {'M', 'P', 'F'};
+
+static int obstacles_of_each_kind(int rows, int cols)
+{
+    int total_cells = rows * cols;
+    return (total_cells > 500) ? 10 : std::min(8, total_cells / 100);
+}
+
+int Arena::max_obstacles(int rows, int cols)
+{
+    return static_cast<int>(sizeof(obstacle_kinds)) * obstacles_of_each_kind(rows, cols);
+}
+
 void Arena::initialize_board(bool empty) 
 {
 
-    // Resize the board and initialize all cells to '.'
-    m_board.resize(m_size_row, std::vector<char>(m_size_col, '.'));
+    // initialize all cells to '.' - nobody is standing on them anymore either
+    m_board.reset();
+    std::fill(m_occupant.begin(), m_occupant.end(), -1);
     
     //empty makes it so there are no obstacles.
     if(empty)
         return;
 
     // Determine the maximum number of obstacles based on the size of the board
-    int total_cells = m_size_row * m_size_col;
-    int max_obstacles = (total_cells > 500) ? 10 : std::min(8, total_cells / 100);
-
-    // Obstacle types to place
-    std::vector<char> obstacle_types = {'M', 'P', 'F'};
+    int max_obstacles = obstacles_of_each_kind(m_size_row, m_size_col);
 
-    for (char obstacle : obstacle_types) 
+    for (char obstacle : obstacle_kinds) 
     {
         // Random number of obstacles for this type (between 0 and max_obstacles)
-        int obstacle_count = std::rand() % (max_obstacles + 1);
+        int obstacle_count = m_map_random.below(max_obstacles + 1);
 
         for (int i = 0; i < obstacle_count; ++i) 
         {
@@ -730,13 +771,13 @@ void Arena::initialize_board(bool empty)
             do 
             {
                 // Randomly generate a position within the board
-                row = std::rand() % m_size_row;
-                col = std::rand() % m_size_col;
+                row = m_map_random.below(m_size_row);
+                col = m_map_random.below(m_size_col);
             } 
-            while (m_board[row][col] != '.'); // Ensure the position is empty
+            while (m_board.get(row, col) != '.'); // Ensure the position is empty
 
             // Place the obstacle
-            m_board[row][col] = obstacle;
+            m_board.set(row, col, obstacle);
         }
     }
 
@@ -750,76 +791,150 @@ void Arena::print_board(int round, std::ostream& out, bool clear_screen) const {
         }
     }
 
-    out << std::endl << "              =========== starting round " << round << " ===========" << std::endl;
+    std::string text;
+    print_board(round, text);
+    out << text;
+}
 
-    // Calculate consistent spacing for the columns
-    const int col_width = 3; // Adjust width for even spacing (enough for two-digit numbers and a space)
+void Arena::print_board(int round, std::string& text) const {
+    int first = m_board.index(0, 0);
+    format_board(round, m_size_row, m_size_col, m_board.data() + first, m_occupant.data() + first, m_board.stride(), text);
+}
 
-    // Print column headers with consistent spacing
-    out << "   "; // Leading space for row indices
-    for (int col = 0; col < m_size_col; ++col) {
-        out << std::setw(col_width) << col; // Use std::setw for fixed width
-    }
-    out << std::endl;
+int Arena::get_robot_index(int row, int col) const
+{
+    return m_occupant[m_board.index(row, col)]; // -1 if no robot is there
+}
 
-    // Print each row of the arena
-    for (int row = 0; row < m_size_row; ++row) {
-        // Print row index with consistent spacing
-        out << std::setw(2) << row << " "; // Row indices aligned with column headers
+// The live robot in a cell, or -1. Dead robots ('X') don't count.
+int Arena::robot_at(int row, int col) const
+{
+    return robot_at_index(m_board.index(row, col));
+}
 
-        // Print the contents of the row
-        for (int col = 0; col < m_size_col; ++col) {
-            char cell = m_board[row][col];
-            if (cell == 'R' || cell == 'X') {
-                int bot_index = get_robot_index(row, col);
-                if (bot_index != -1) {
-                    // Append the unique character to 'R' or 'X'
-                    out << std::setw(col_width - 1) << cell << unique_char[bot_index];
-                } else {
-                    // Default display if robot index is invalid
-                    out << std::setw(col_width) << cell;
-                }
-            } else {
-                // Display other cells as-is
-                out << std::setw(col_width) << cell;
-            }
-        }
-        out << std::endl;
-    }
+int Arena::robot_at_index(int index) const
+{
+    return m_board.bit(layer_robot, index) ? m_occupant[index] : -1;
 }
 
-int Arena::get_robot_index(int row, int col) const
+// Put a robot in the arena at (row, col) and mark it on the board
+void Arena::add_robot(RobotBase* robot, int row, int col)
+{
+    robot->move_to(row, col);
+    m_board.set(row, col, 'R');
+    int slot = static_cast<int>(m_robots.size());
+    m_occupant[m_board.index(row, col)] = slot;
+    m_robots.push_back(robot);
+
+    m_state.row.push_back(row);
+    m_state.col.push_back(col);
+    m_state.health.push_back(0);
+    m_state.armor.push_back(0);
+    m_state.move.push_back(0);
+    m_state.grenades.push_back(0);
+    m_state.weapon.push_back(robot->get_weapon());
+    m_state.alive.push_back(1);
+    m_alive.push_back(slot);
+    m_damage_random.emplace_back(m_seed, random_damage + slot);
+    sync_robot(slot);
+}
+
+template <typename Value>
+static void put(std::string& out, Value value)
 {
-    for (size_t i = 0; i < m_robots.size(); ++i)
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+std::string Arena::save_state() const
+{
+    std::string out;
+    put<std::uint32_t>(out, m_seed);
+    put<std::int32_t>(out, m_rounds_played);
+    put<std::int32_t>(out, m_size_row);
+    put<std::int32_t>(out, m_size_col);
+    for (int row = 0; row < m_size_row; ++row)
     {
-        int robot_row, robot_col;
-        m_robots[i]->get_current_location(robot_row, robot_col);
+        out.append(m_board.data() + m_board.index(row, 0), m_size_col);
+    }
 
-        if (robot_row == row && robot_col == col)
+    // who's in which cell follows from the rows and columns - dead robots keep theirs
+    put<std::int32_t>(out, static_cast<std::int32_t>(m_robots.size()));
+    for (std::size_t slot = 0; slot < m_robots.size(); ++slot)
+    {
+        for (int field : {m_state.row[slot], m_state.col[slot], m_state.health[slot], m_state.armor[slot],
+                          m_state.move[slot], m_state.grenades[slot], static_cast<int>(m_state.weapon[slot]),
+                          static_cast<int>(m_state.alive[slot])})
         {
-            return static_cast<int>(i);
+            put<std::int32_t>(out, field);
         }
     }
-    return -1; // No robot found at the specified location
+    put<std::int32_t>(out, static_cast<std::int32_t>(m_alive.size()));
+    for (int slot : m_alive)
+    {
+        put<std::int32_t>(out, slot);
+    }
+
+    put<std::uint64_t>(out, m_map_random.drawn());
+    put<std::uint64_t>(out, m_placement_random.drawn());
+    for (const RandomStream& random : m_damage_random)
+    {
+        put<std::uint64_t>(out, random.drawn());
+    }
+    put<std::uint64_t>(out, m_stray_random.drawn());
+    return out;
+}
+
+// Read a robot's fields back into m_state after Arena has changed them
+void Arena::sync_robot(int slot)
+{
+    RobotBase* robot = m_robots[slot];
+    robot->get_current_location(m_state.row[slot], m_state.col[slot]);
+    m_state.health[slot] = robot->get_health();
+    m_state.armor[slot] = robot->get_armor();
+    m_state.move[slot] = robot->get_move();
+    m_state.grenades[slot] = robot->get_grenades();
+}
+
+// A dead robot becomes an 'X' where it fell and stops taking turns
+void Arena::retire_robot(int slot)
+{
+    m_board.set(m_state.row[slot], m_state.col[slot], 'X');
+    m_state.alive[slot] = 0;
+    m_alive.erase(std::find(m_alive.begin(), m_alive.end(), slot));
+}
+
+// Take all the robots out of the arena. Their marks stay on the board.
+void Arena::clear_robots()
+{
+    for (auto* robot : m_robots)
+    {
+        int row, col;
+        robot->get_current_location(row, col);
+        m_occupant[m_board.index(row, col)] = -1;
+    }
+    m_robots.clear();
+    m_state = RobotTable();
+    m_alive.clear();
+    m_damage_random.clear();
 }
 
 bool Arena::winner()
 {
     int num_living_robots = 0;
-    RobotBase *living_robot;
+    int living_robot = -1;
 
-    for (auto* robot : m_robots)
+    for (int slot : m_alive)
     {
-        if(robot->get_health() > 0)
+        if(m_state.health[slot] > 0)
         {
             num_living_robots++;
-            living_robot = robot;
+            living_robot = slot;
         }
     }
 
     if(num_living_robots == 1)
     {
-        std::cout << living_robot->m_name << " is the winner.\n";
+        m_winner = living_robot;
         return true;
     }
 
@@ -827,86 +942,273 @@ bool Arena::winner()
 
 }
 
-void Arena::output(std::string text, std::ostream& file)
+// log text goes to both sinks, when there are sinks. Outside of run_simulation it's just cout.
+// The live view has the console to itself while it's up.
+void Arena::output(std::string_view text)
 {
-    std::cout << text;
-    file << text;
+    if (!m_live_view)
+    {
+        console(text);
+    }
+    if (m_file_log)
+    {
+        m_file_log->write(text);
+    }
+    if (m_compressed_log)
+    {
+        m_compressed_log->write(text);
+    }
+}
+
+void Arena::console(std::string_view text)
+{
+    if (m_console_log)
+    {
+        m_console_log->write(text);
+    }
+    else
+    {
+        std::cout << text;
+    }
 }
 
 // Run the simulation
 // assumes robots have been loaded.
 void Arena::run_simulation(bool live) 
 {
-    std::stringstream ss;
+    // open a log file, and put a sink on it and on the console. Anything already in
+    // cout's buffer goes out first so it doesn't end up behind the sink's text.
+    // A compressed log is one game per file, so it starts over instead of appending.
+    const bool quiet = (m_log_options.level == LogLevel::off);
+    const bool compress = m_log_options.file && m_log_options.compress && !quiet;
+    int log_fd = -1;
+    if (compress)
+        log_fd = ::open((m_log_options.file_name + ".gz").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    else if (m_log_options.file && !quiet)
+        log_fd = ::open(m_log_options.file_name.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (m_log_options.console)
+        std::cout.flush();
+    m_console_log = std::make_unique<LogSink>(STDOUT_FILENO, m_log_options.console && (!quiet || live), m_log_options.console_flush, m_log_options.flush_kb);
+    m_file_log = std::make_unique<LogSink>(log_fd, m_log_options.file && !compress, m_log_options.file_flush, m_log_options.flush_kb);
+    if (compress && log_fd >= 0)
+    {
+        m_compressed_log = std::make_unique<CompressedLog>(log_fd, m_log_options.flush_kb);
+    }
+    int replay_fd = -1;
+    if (m_log_options.replay)
+    {
+        replay_fd = ::open(m_log_options.replay_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    if (replay_fd >= 0)
+    {
+        const int first = m_board.index(0, 0);
+        m_replay = std::make_unique<ReplayWriter>(replay_fd, m_size_row, m_size_col, m_seed, m_robots,
+                                                  m_board.data() + first, m_board.stride());
+    }
 
-    std::vector<RadarObj> radar_results;
-    std::ostringstream outstring;
+    if(m_robots.size() == 0)
+    {
+        output("Robot list did not load.");
+    }
+    else
+    {
+#ifdef ROBOTWARZ_LOG_LEVEL
+        // built for one log level, the others don't exist
+        play_at<static_cast<LogLevel>(ROBOTWARZ_LOG_LEVEL)>(live);
+#else
+        switch (m_log_options.level)
+        {
+            case LogLevel::off:     play_at<LogLevel::off>(live);         break;
+            case LogLevel::summary: play_at<LogLevel::summary>(live);     break;
+            case LogLevel::turn:    play_at<LogLevel::turn>(live);        break;
+            case LogLevel::board:   play_at<LogLevel::board>(live);       break;
+        }
+#endif
+    }
+
+    // the sinks write out whatever is still in their rings as they go
+    m_console_log.reset();
+    m_file_log.reset();
+    m_compressed_log.reset();
+    m_replay.reset();
+    if (log_fd >= 0)
+    {
+        ::close(log_fd);
+    }
+    if (replay_fd >= 0)
+    {
+        ::close(replay_fd);
+    }
+};
+
+// Whether anything reads the turn events is settled here, once, so the turn loop
+// doesn't ask. A replay needs them whatever the level is.
+template <LogLevel level>
+void Arena::play_at(bool live)
+{
+    if constexpr (level >= LogLevel::turn)
+    {
+        play_rounds<level, true>(live);
+    }
+    else if (m_replay)
+    {
+        play_rounds<level, true>(live);
+    }
+    else
+    {
+        play_rounds<level, false>(live);
+    }
+}
 
-   // Seed the random number generator
-    std::srand(static_cast<unsigned>(std::time(nullptr)));
+// The game itself, with everything below 'level' compiled out. 'level' only decides
+// what gets written - the game plays out the same at every level. Without 'record' the
+// handlers still add their events, but they're dropped at the end of every turn, so the
+// buffer stays a few events long.
+template <LogLevel level, bool record>
+void Arena::play_rounds(bool live)
+{
+    std::vector<RadarObj> radar_results;
+    std::string round_text;
+    const bool text_log = m_console_log->enabled() || m_file_log->enabled() || m_compressed_log;
+    const int first = m_board.index(0, 0);
+    const ViewOptions& view = m_log_options.view;
+    BoardRenderer renderer(m_size_row, m_size_col, view.rows, view.cols);
+    if (live && m_console_log->enabled())
+    {
+        m_live_view = std::make_unique<LiveView>(m_size_row, m_size_col, view.rows, view.cols, m_live_tick_ms, true);
+    }
+    if (m_log_options.frames_every > 0)
+    {
+        m_frames = std::make_unique<FrameExporter>(m_log_options.frames_directory, m_size_row, m_size_col,
+                                                   m_log_options.frames_png ? FrameExporter::png : FrameExporter::ppm);
+        check_frames();
+    }
+    if (!m_log_options.spectate.empty())
+    {
+        m_spectators = std::make_unique<SpectatorFeed>(m_log_options.spectate, m_size_row, m_size_col, m_robots);
+        if (!m_spectators->ok())
+        {
+            console("Couldn't set up " + m_log_options.spectate + " for spectators.\n");
+            m_spectators.reset();
+        }
+    }
+    if (view.minimap > 0)
+    {
+        m_minimap = std::make_unique<Minimap>(m_size_row, m_size_col, view.minimap, m_board.data() + first, m_board.stride());
+    }
 
-    // open a log file.
-    std::ofstream log_file("RobotWarz_log.txt", std::ios::app);
+    // room for a busy round up front, so the event buffer doesn't grow mid game
+    if constexpr (record)
+    {
+        m_events.reserve(m_robots.size() * 16);
+    }
 
-    if(m_robots.size() == 0)
+    // what it takes to play this match again
+    if constexpr (level >= LogLevel::summary)
     {
-        output("Robot list did not load.",log_file);
-        return;
+        output("match seed " + std::to_string(m_seed) + "\n");
     }
 
     int round = 0;
-    while(!winner() && round < 1000000)
+    m_winner = -1;
+    while(!winner() && !m_alive.empty() && round < m_round_limit)
     {
-        int row, col;
-        char robot_id;
+        m_events.clear();
+        m_rounds_played = round;
+        if (m_round_hook)
+        {
+            m_round_hook(round);
+        }
+        if (m_replay)
+        {
+            m_replay->begin_round(round, m_board.data() + first, m_occupant.data() + first, m_board.stride());
+        }
+
+        if (m_frames && round % m_log_options.frames_every == 0)
+        {
+            m_frames->add_frame(round, m_board.data() + first, m_occupant.data() + first, m_board.stride());
+            check_frames();
+        }
+        if (m_spectators)
+        {
+            publish_round(round);
+        }
+
+        int top = 0, left = 0;
+        if (m_live_view || level >= LogLevel::board)
+        {
+            view_origin(renderer, top, left);
+        }
+
+        if constexpr (level >= LogLevel::board)
+        {
+            const int every = m_log_options.board_every;
+            if (text_log && (every <= 0 || round % every == 0))
+            {
+                std::string_view frame = renderer.render(round, m_board.data() + first, m_occupant.data() + first, m_board.stride(), top, left);
+                if (every > 0 || renderer.changed())
+                {
+                    output(frame);
+                    if (m_minimap)
+                    {
+                        output(m_minimap->render(m_state.row, m_state.col, m_state.alive, renderer.top(), renderer.left(),
+                                                 renderer.view_rows(), renderer.view_cols()));
+                    }
+                }
+            }
+        }
 
-        print_board(round, std::cout, live);
-        print_board(round, log_file, false);
+        if (m_live_view)
+        {
+            draw_live(round, top, left);
+        }
 
-        for (auto* robot : m_robots) 
+        // robots that died drop out of m_alive when their turn comes round, so step by hand
+        for (size_t turn = 0; turn < m_alive.size(); ) 
         {
-            robot->get_current_location(row, col);
-            robot_id = unique_char[get_robot_index(row, col)];
+            int slot = m_alive[turn];
+            RobotBase* robot = m_robots[slot];
 
-            // Handle dead robots
-            if (robot->get_health() <= 0) 
+            // Handle dead robots - this is the only time they get a line in the log
+            if (m_state.health[slot] <= 0) 
             {
-                ss << robot->m_name << " " << robot_id << " is out." << std::endl;
-                output(ss.str(),log_file);
-                if (m_board[row][col] != 'X') 
+                if constexpr (record)
                 {
-                    m_board[row][col] = 'X';
+                    add_event(TurnEventType::death, robot).robot_id = robot_symbol(slot);
                 }
+                retire_robot(slot);
                 continue;
             }
-            
-            int bot_index = get_robot_index(row, col);
-            if (bot_index != -1) 
+            ++turn;
+
+            if constexpr (record)
+            {
+                add_stats_event(slot);
+            }
+
+            // from here on it's the robot's own code running
+            if (m_turn_marker)
             {
-                    // Append the unique character to 'R' or 'X'
-                    outstring.str("");
-                    outstring << unique_char[bot_index];
-                    output(outstring.str(),log_file);
+                m_turn_marker->store(slot, std::memory_order_relaxed);
             }
-            output(robot->print_stats(),log_file);
 
             //handle radar
             if(robot->radar_enabled())
             {
-                output( "  checking radar, direction: ", log_file);
                 int radar_dir;
                 robot->get_radar_direction(radar_dir);
-                outstring.str("");
-                outstring << radar_dir << " ... ";
-                output( outstring.str(),log_file );
                 get_radar_results(robot,radar_dir,radar_results);
 
-                if(radar_results.empty())
-                    output( " found nothing. ",log_file);
-                else
-                {   outstring.str("");
-                    outstring << " found '" << radar_results[0].m_type << "' at (" << radar_results[0].m_row << "," << radar_results[0].m_col << ") ";
-                    output (outstring.str(),log_file);
+                if constexpr (record)
+                {
+                    TurnEvent& radar = add_event(TurnEventType::radar, robot);
+                    radar.amount = static_cast<std::int16_t>(radar_dir);
+                    if(!radar_results.empty())
+                    {
+                        radar.detail = radar_results[0].m_type;
+                        radar.row = static_cast<std::int16_t>(radar_results[0].m_row);
+                        radar.col = static_cast<std::int16_t>(radar_results[0].m_col);
+                    }
                 }
 
                 robot->process_radar_results(radar_results);
@@ -916,29 +1218,211 @@ void Arena::run_simulation(bool live)
             int shot_row = 0, shot_col = 0;
             if (robot->get_shot_location(shot_row, shot_col)) 
             {
-                output("Shooting: ",log_file);
-                output(handle_shot(robot, shot_row, shot_col), log_file);
+                handle_shot(robot, shot_row, shot_col);
             } 
             else 
             {
-                output("Moving: ",log_file);
-                output(handle_move(robot),log_file);
+                handle_move(robot);
             }
+            sync_robot(slot);
 
             //next robot line.
-            output("\n",log_file);
+            if constexpr (record)
+            {
+                add_event(TurnEventType::turn_end, robot);
+            }
+            else
+            {
+                m_events.clear();   // nobody reads them
+            }
+        }
+
+        if (m_turn_marker)
+        {
+            m_turn_marker->store(-1, std::memory_order_relaxed);
+        }
+
+        // the text log is just another reader of the round's events
+        if constexpr (level >= LogLevel::turn)
+        {
+            if (text_log)
+            {
+                round_text.clear();
+                format_turn_events(m_events, round_text);
+                output(round_text);
+            }
+        }
+        if (m_replay)
+        {
+            m_replay->end_round(m_events);
+        }
+        m_console_log->end_round();
+        m_file_log->end_round();
+        if (m_compressed_log)
+        {
+            m_compressed_log->end_round();
         }
 
-        // Pause for 1 second if live is true
-        if (live)
+        // wait for the next tick, and keep an eye on the keys while we do
+        if (m_live_view)
         {
-            sleep(1); // Plain C-style sleep
+            m_live_view->wait_for_tick();
         }
 
         round++;
 
     }
+    m_rounds_played = round;
+
+    if (m_live_view)
+    {
+        int top = 0, left = 0;
+        view_origin(renderer, top, left);
+        draw_live(round, top, left);
+        round_text.clear();
+        m_live_view->close(round_text);
+        console(round_text);
+        m_live_view.reset();
+    }
+    m_minimap.reset();
+    if (m_frames)
+    {
+        m_frames->flush();  // the last pictures, so a failure writing them gets reported too
+        check_frames();
+        m_frames.reset();
+    }
+    if (m_spectators)
+    {
+        publish_round(round);   // how it ended
+        m_spectators.reset();
+    }
+
+    // the winner, and where everybody ended up
+    if (level >= LogLevel::summary || m_replay)
+    {
+        m_events.clear();
+        for (size_t slot = 0; slot < m_robots.size(); ++slot)
+        {
+            add_stats_event(static_cast<int>(slot));
+            add_event(TurnEventType::turn_end, m_robots[slot]);
+        }
+        if (m_replay)
+        {
+            m_replay->finish(round, m_events);
+        }
+    }
+    if constexpr (level >= LogLevel::summary)
+    {
+        if (winner())
+        {
+            console(m_robots[m_winner]->m_name + " is the winner.\n");
+        }
+
+        round_text = "final stats after " + std::to_string(round) + " rounds:\n";
+        format_turn_events(m_events, round_text);
+        output(round_text);
+
+        console("game over.");
+    }
+}
+
+// the live view's screen updates for the start of 'round', with the viewport at (top, left)
+void Arena::draw_live(int round, int top, int left)
+{
+    std::vector<std::string> lines;
+    for (size_t slot = 0; slot < m_robots.size(); ++slot)
+    {
+        lines.push_back(robot_symbol(static_cast<int>(slot)) + m_robots[slot]->print_stats());
+    }
+    if (m_minimap)
+    {
+        const ViewOptions& view = m_log_options.view;
+        std::string_view map = m_minimap->render(m_state.row, m_state.col, m_state.alive, top, left,
+                                                 view.rows > 0 ? view.rows : m_size_row, view.cols > 0 ? view.cols : m_size_col);
+        lines.emplace_back();
+        for (std::size_t end; (end = map.find('\n')) != std::string_view::npos; map.remove_prefix(end + 1))
+        {
+            lines.emplace_back(map.substr(0, end));
+        }
+    }
+
+    std::string screen;
+    const int first = m_board.index(0, 0);
+    m_live_view->draw(round, m_board.data() + first, m_occupant.data() + first, m_board.stride(), top, left, lines, screen);
+    console(screen);
+}
+
+// a frame that couldn't be written means the rest won't be either: say so once, and stop
+void Arena::check_frames()
+{
+    if (m_frames && !m_frames->ok())
+    {
+        console("Couldn't write frames to " + m_log_options.frames_directory + ", not saving any more.\n");
+        m_frames.reset();
+    }
+}
+
+// the board and everybody's stats at the start of 'round', for whoever is watching
+void Arena::publish_round(int round)
+{
+    m_spectators->publish(round, m_board.data() + m_board.index(0, 0), m_board.stride(), m_state.row, m_state.col,
+                          m_state.health, m_state.armor, m_state.move, m_state.alive);
+}
+
+// Where the viewport goes this round: on the robot it follows while that one is alive,
+// else on the biggest crowd of live robots if it follows the fighting, else where the
+// options put it. The renderer keeps it on the board.
+void Arena::view_origin(const BoardRenderer& renderer, int& top, int& left) const
+{
+    const ViewOptions& view = m_log_options.view;
+    top = std::clamp(view.top, 0, m_size_row - renderer.view_rows());
+    left = std::clamp(view.left, 0, m_size_col - renderer.view_cols());
+
+    const int follow = view.follow;
+    if (follow >= 0 && follow < static_cast<int>(m_robots.size()) && m_state.alive[follow])
+    {
+        renderer.center_on(m_state.row[follow], m_state.col[follow], top, left);
+        return;
+    }
+    if (!view.follow_fight || m_alive.empty())
+    {
+        return;
+    }
 
-    std::cout << "game over.";
+    // the robot with the most others within half a window of it, and the middle of that bunch
+    const int reach_rows = renderer.view_rows() / 2, reach_cols = renderer.view_cols() / 2;
+    int best = -1, best_row = 0, best_col = 0;
+    for (int a : m_alive)
+    {
+        int count = 0, row_sum = 0, col_sum = 0;
+        for (int b : m_alive)
+        {
+            if (std::abs(m_state.row[a] - m_state.row[b]) <= reach_rows && std::abs(m_state.col[a] - m_state.col[b]) <= reach_cols)
+            {
+                ++count;
+                row_sum += m_state.row[b];
+                col_sum += m_state.col[b];
+            }
+        }
+        if (count > best)
+        {
+            best = count;
+            best_row = row_sum / count;
+            best_col = col_sum / count;
+        }
+    }
+    renderer.center_on(best_row, best_col, top, left);
+}
 
-};
\ No newline at end of file
+// a robot's id and stats as a 'turn' event, from the copy in m_state
+void Arena::add_stats_event(int slot)
+{
+    TurnEvent& stats = add_event(TurnEventType::turn, m_robots[slot]);
+    stats.robot_id = robot_symbol(slot);
+    stats.detail = static_cast<char>(m_state.weapon[slot]);
+    stats.row = static_cast<std::int16_t>(m_state.row[slot]);
+    stats.col = static_cast<std::int16_t>(m_state.col[slot]);
+    stats.health = static_cast<std::int16_t>(m_state.health[slot]);
+    stats.armor = static_cast<std::int16_t>(m_state.armor[slot]);
+    stats.move = static_cast<std::int16_t>(m_state.move[slot]);
+}
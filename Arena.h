@@ -2,50 +2,310 @@
 #define __ARENA_H__
 
 #include "RobotBase.h"
+#include "Board.h"
+#include "TurnEvents.h"
+#include "LogSink.h"
+#include "CompressedLog.h"
+#include "Replay.h"
+#include "BoardRenderer.h"
+#include "LiveView.h"
+#include "FrameExport.h"
+#include "SpectatorFeed.h"
+#include "Random.h"
+#include "RobotLibrary.h"
 #include <vector>
 #include <iostream>
 #include <iomanip>
 #include <set>
+#include <bit>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <atomic>
+#include <functional>
+#include <string>
 
 class TestArena; // Forward declaration of the test class
 
+// The lanes of a radar beam in one direction, worked out once. Each lane is the line of
+// cells (d_row, d_col) + step * direction for step = 1, 2, ... - the middle of the beam, the
+// cells either side of it and, on diagonals, the two holes between steps - in scan order.
+// The beam runs along 'orientation' in the board layers, 'forward' if that's the way the
+// layer counts up.
+struct RadarLanes {
+    Board::Orientation orientation;
+    bool forward;
+    int count;
+    int d_row[5], d_col[5];
+};
+
+// Arena's own copy of the robot fields it looks at, one array per field, by robot index
+// (the same index as m_robots). The per-round passes read these instead of calling into
+// every robot. It's kept up to date wherever Arena calls a RobotBase mutator.
+struct RobotTable {
+    std::vector<int> row, col;
+    std::vector<int> health, armor, move, grenades;
+    std::vector<WeaponType> weapon;
+    std::vector<std::uint8_t> alive;    // still in the game - cleared once it's marked 'X'
+};
+
+// How much of the game gets written down. Each level has everything the one before it has.
+//   off     - nothing at all
+//   summary - the winner and every robot's stats at the end
+//   turn    - plus a line per robot per round
+//   board   - plus the board at the start of every round
+enum class LogLevel { off, summary, turn, board };
+
+// Which part of the board gets shown, in the log and live. 0 rows or cols is all of them.
+struct ViewOptions {
+    int rows = 0, cols = 0;
+    int top = 0, left = 0;              // where the window sits when it isn't following anything
+    int follow = -1;                    // keep this robot (by index) in the middle while it's alive
+    bool follow_fight = false;          // or the spot with the most live robots close together
+    int minimap = 0;                    // minimap width in characters, 0 for no minimap
+};
+
+// Where the text log goes and when it gets pushed out (see LogSink)
+struct LogOptions {
+    LogLevel level = LogLevel::board;
+    bool console = true;
+    bool file = true;                   // the log file, file_name
+    bool compress = false;              // the file is file_name.gz instead (see CompressedLog)
+    std::string file_name = "RobotWarz_log.txt";
+    LogSink::Flush console_flush = LogSink::every_round;
+    LogSink::Flush file_flush = LogSink::every_kb;
+    std::size_t flush_kb = 64;
+    bool replay = false;                // also record replay_name (see Replay), whatever the level
+    std::string replay_name = "RobotWarz.replay";
+    int board_every = 1;                // print the board every N rounds, 0: only when it changed
+    ViewOptions view;
+    int frames_every = 0;               // save every Nth round's board as a picture, 0 for none
+    bool frames_png = false;            // PNG instead of PPM (see FrameExporter)
+    std::string frames_directory = "RobotWarz_frames";
+    std::string spectate;               // publish every round in this shared memory region (see SpectatorFeed)
+};
+
 class Arena {
     friend class TestArena; // Allow the test class to access private members
 
 private:
     int m_size_row, m_size_col;
-    std::vector<std::vector<char>> m_board;
+    Board m_board;
     std::vector<RobotBase*> m_robots;
 
+    // which robot is in each cell - an index into m_robots, or -1. Same flat indexes as m_board.
+    // Dead robots keep their cell (the 'X') so they still show up on the board.
+    std::vector<int> m_occupant;
+
+    RobotTable m_state;
+    std::vector<int> m_alive;   // indexes of the robots still in the game, in order
+
+    // Everything random in the game comes from these, all from the one seed (see RandomStream)
+    std::uint32_t m_seed;
+    RandomStream m_map_random;                  // obstacles
+    RandomStream m_placement_random;            // where robots start
+    std::vector<RandomStream> m_damage_random;  // damage rolls against each robot, by robot index
+    RandomStream m_stray_random;                // damage to a robot that isn't in m_robots
+    RandomStream& damage_random(const RobotBase* robot);    // for a robot whose slot isn't known
+
+    // everything that happened this round, in order. Cleared at the start of each round.
+    std::vector<TurnEvent> m_events;
+
+    // the text log. The sinks only exist while run_simulation is going.
+    LogOptions m_log_options;
+    std::unique_ptr<LogSink> m_console_log;
+    std::unique_ptr<LogSink> m_file_log;
+    std::unique_ptr<CompressedLog> m_compressed_log;    // in place of m_file_log with LogOptions::compress
+    std::unique_ptr<ReplayWriter> m_replay;             // with LogOptions::replay
+    void console(std::string_view text);
+
+    // -live=true: the console shows the board and stats through this instead of the text log
+    std::unique_ptr<LiveView> m_live_view;
+    int m_live_tick_ms = 1000;
+    void draw_live(int round, int top, int left);
+
+    // the viewport (LogOptions::view)
+    std::unique_ptr<Minimap> m_minimap;
+    void view_origin(const BoardRenderer& renderer, int& top, int& left) const;
+
+    std::unique_ptr<FrameExporter> m_frames;    // with LogOptions::frames_every, into LogOptions::frames_directory
+    void check_frames();
+    std::unique_ptr<SpectatorFeed> m_spectators;    // with LogOptions::spectate
+    void publish_round(int round);
+
+    int m_winner = -1;              // set by winner()
+    int m_rounds_played = 0;
+    int m_round_limit = 1000000;
+    std::atomic<int>* m_turn_marker = nullptr;
+    std::function<void(int round)> m_round_hook;
+    template <LogLevel level> void play_at(bool live);
+    template <LogLevel level, bool record> void play_rounds(bool live);
+    void add_stats_event(int slot);
+    TurnEvent& add_event(TurnEventType type, const RobotBase* robot);
+
     //radar 
-    void scan_location(int row, int col, std::vector<RadarObj>& radar_results);
+    RadarLanes m_radar_lanes[9]; // by radar direction, [0] (local radar) isn't used
+    void build_radar_lanes();
     void get_radar_results(RobotBase* robot, int radar_direction, std::vector<RadarObj>& radar_results);
     void get_radar_local(RobotBase* robot, std::vector<RadarObj>& radar_results);
     void get_radar_ray(RobotBase* robot, int radar_direction, std::vector<RadarObj>& radar_results);
 
+    // area of effect queries. Each one calls visit(robot index) for every live robot ('R')
+    // in the footprint, row by row and left to right. They use the robot bits on the board,
+    // so empty cells cost nothing, and they don't allocate.
+    int robot_at(int row, int col) const;
+    int robot_at_index(int index) const;
+    template <typename Visit> void robots_in_span(int row, int left, int right, Visit visit) const;
+    template <typename Visit> void robots_in_row_mask(int row, int left, std::uint64_t mask, Visit visit) const;
+    template <typename Visit> void robots_in_rect(int top, int left, int bottom, int right, Visit visit) const;
+    template <typename Visit> void robots_in_disc(int row, int col, int radius, Visit visit) const;
+
     //shot
-    std::string handle_shot(RobotBase* robot, int shot_row, int shot_col);
-    std::string handle_flame_shot(RobotBase* robot, int shot_row, int shot_col);
-    std::string handle_railgun_shot(RobotBase* robot, int shot_row, int shot_col);
-    std::string handle_grenade_shot(RobotBase* robot, int shot_row, int shot_col);
-    std::string handle_hammer_shot(RobotBase* robot, int shot_row, int shot_col);
-    int calculate_damage(WeaponType weapon, int armor_level);
-    std::string apply_damage_to_robot(RobotBase* robot, WeaponType weapon);
+    void handle_shot(RobotBase* robot, int shot_row, int shot_col);
+    void handle_flame_shot(RobotBase* robot, int shot_row, int shot_col);
+    void handle_railgun_shot(RobotBase* robot, int shot_row, int shot_col);
+    void trace_railgun(int from_row, int from_col, int shot_row, int shot_col, std::vector<int>& hits) const;
+    void handle_grenade_shot(RobotBase* robot, int shot_row, int shot_col);
+    void handle_hammer_shot(RobotBase* robot, int shot_row, int shot_col);
+    int calculate_damage(WeaponType weapon, int armor_level, RandomStream& random);
+    void apply_damage_to_robot(RobotBase* robot, WeaponType weapon);
+    void apply_damage_to_robot(int slot, WeaponType weapon);
+    void apply_damage_to_robot(RobotBase* robot, WeaponType weapon, RandomStream& random);
 
     //move
-    std::string handle_move(RobotBase* robot);
-    std::string handle_collision(RobotBase* robot, char cell, int row, int col);
+    void handle_move(RobotBase* robot);
+    void handle_collision(RobotBase* robot, char cell, int row, int col);
 
     bool winner();
     int get_robot_index(int row, int col) const;
+    void add_robot(RobotBase* robot, int row, int col);
+    void clear_robots();
+    void sync_robot(int slot);
+    void retire_robot(int slot);
 
 public:
-    Arena(int row_in, int col_in);
+    Arena(int row_in, int col_in, std::uint32_t seed = 0);
+    std::uint32_t seed() const { return m_seed; }
     bool load_robots();
-    void output(std::string text,std::ostream& out_file);
+    void output(std::string_view text);
     void initialize_board(bool empty=false);
+    // the most obstacles initialize_board() can put down on a board that size, all kinds together
+    static int max_obstacles(int rows, int cols);
     void print_board(int round, std::ostream& out, bool clear_screen) const;
+    void print_board(int round, std::string& text) const;   // appends it to 'text'
     void run_simulation(bool live = false);
+
+    // with both sinks turned off the board isn't printed and the events aren't formatted
+    void set_log_options(const LogOptions& options) { m_log_options = options; }
+    void set_live_tick(int tick_ms) { m_live_tick_ms = tick_ms; }   // ms a round in live mode, 0 for full speed
+
+    // how many cells 'robot' could move in 'move_direction' (1..8) this turn without
+    // hitting anything - at most its move speed
+    int max_reachable(RobotBase* robot, int move_direction) const;
+
+    // Puts a robot nobody else has placed on a random empty cell, named 'name'. The arena
+    // doesn't own it - it has to outlive the arena.
+    void place_robot(RobotBase* robot, const std::string& name, int& row, int& col);
+
+    // A match stops when one robot is left, nobody is, or after this many rounds
+    void set_round_limit(int rounds) { m_round_limit = rounds; }
+
+    // While a robot takes its turn 'marker' holds its index, between turns -1. Whoever
+    // finds the game dead or stuck can see which robot's code it was in.
+    void set_turn_marker(std::atomic<int>* marker) { m_turn_marker = marker; }
+
+    // called at the start of every round, before anybody moves, with the rounds played so far
+    void set_round_hook(std::function<void(int round)> hook) { m_round_hook = std::move(hook); }
+
+    // Everything of the game's own that decides how it goes from here, as bytes: the
+    // round, the cells, every robot's row, column, stats and whether it's still in, the
+    // turn order and how far along each random stream is. What's inside the robots isn't
+    // the arena's to write down, so two arenas with the same state only play on the same
+    // way if their robots are in the same state too.
+    std::string save_state() const;
+
+    // how the last run_simulation went: the winner by robot index (-1 for nobody), and
+    // each robot's health at the end
+    int winning_robot() const { return m_winner; }
+    int rounds_played() const { return m_rounds_played; }
+    int final_health(int slot) const { return m_state.health[slot]; }
+
+    // the cells as they are, obstacles and all
+    const Board& board() const { return m_board; }
 };
 
+// every robot in columns left..right of one row
+template <typename Visit>
+void Arena::robots_in_span(int row, int left, int right, Visit visit) const
+{
+    if (row < 0 || row >= m_size_row)
+        return;
+    left = std::max(left, 0);
+    right = std::min(right, m_size_col - 1);
+
+    int index = m_board.index(row, left);
+    for (int count = right - left + 1; count > 0; count -= 64, index += 64)
+    {
+        std::uint64_t bits = m_board.bits(layer_robot, index, std::min(count, 64));
+        while (bits)
+        {
+            int slot = m_occupant[index + std::countr_zero(bits)];
+            bits &= bits - 1;
+            if (slot != -1)
+                visit(slot);
+        }
+    }
+}
+
+// every robot in one row where 'mask' has a bit set - bit 0 is column 'left'
+template <typename Visit>
+void Arena::robots_in_row_mask(int row, int left, std::uint64_t mask, Visit visit) const
+{
+    if (row < 0 || row >= m_size_row)
+        return;
+    if (left < 0)
+    {
+        mask = (left <= -64) ? 0 : mask >> -left;
+        left = 0;
+    }
+    if (left >= m_size_col || mask == 0)
+        return;
+
+    int width = std::min(m_size_col - left, 64);
+    int index = m_board.index(row, left);
+    std::uint64_t bits = m_board.bits(layer_robot, index, width) & mask;
+    while (bits)
+    {
+        int slot = m_occupant[index + std::countr_zero(bits)];
+        bits &= bits - 1;
+        if (slot != -1)
+            visit(slot);
+    }
+}
+
+// every robot in the rectangle, corners included
+template <typename Visit>
+void Arena::robots_in_rect(int top, int left, int bottom, int right, Visit visit) const
+{
+    for (int row = std::max(top, 0); row <= std::min(bottom, m_size_row - 1); ++row)
+    {
+        robots_in_span(row, left, right, visit);
+    }
+}
+
+// every robot no further than 'radius' (straight line) from (row, col)
+template <typename Visit>
+void Arena::robots_in_disc(int row, int col, int radius, Visit visit) const
+{
+    for (int d_row = -radius; d_row <= radius; ++d_row)
+    {
+        // widest column offset still inside the circle on this row
+        int half_width = 0;
+        while ((half_width + 1) * (half_width + 1) + d_row * d_row <= radius * radius)
+            ++half_width;
+        robots_in_span(row + d_row, col - half_width, col + half_width, visit);
+    }
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "Board.h"
+#include "ScanKernels.h"
+#include "RobotBase.h"
+#include <algorithm>
+
+// Constructor - one allocation for the whole board, border included
+Board::Board(int rows_in, int cols_in)
+    : m_rows(rows_in), m_cols(cols_in), m_stride(cols_in + 2), m_height(rows_in + 2)
+{
+    int words = (cell_count() + 63) / 64;
+    m_cells.resize(words * 64, wall);
+
+    // one spare word on the end of every layer so extract() can always read the next word
+    for (auto& layer : m_layers)
+    {
+        layer.resize(words + 1, 0);
+    }
+    int diagonals = m_height + m_stride - 1;
+    m_any_by[by_col].resize(m_stride * m_height / 64 + 2, 0);
+    m_any_by[by_diag].resize(diagonals * m_height / 64 + 2, 0);
+    m_any_by[by_anti].resize(diagonals * m_height / 64 + 2, 0);
+
+    for (int direction = 1; direction <= 8; ++direction)
+    {
+        m_step[direction] = directions[direction].first * m_stride + directions[direction].second;
+        m_free_run[direction].resize(cell_count(), 0);
+    }
+
+    reset();
+}
+
+void Board::reset(char fill)
+{
+    for (int row = -1; row <= m_rows; ++row)
+    {
+        for (int col = -1; col <= m_cols; ++col)
+        {
+            bool border = (row < 0 || row >= m_rows || col < 0 || col >= m_cols);
+            m_cells[index(row, col)] = border ? wall : fill;
+        }
+    }
+    rebuild_layers();
+    rebuild_free_runs();
+}
+
+int Board::layer_of(char cell)
+{
+    switch (cell)
+    {
+        case 'R': return layer_robot;
+        case 'X': return layer_dead;
+        case 'M': return layer_mound;
+        case 'P': return layer_pit;
+        case 'F': return layer_flame;
+        default:  return -1;
+    }
+}
+
+// The row layers are just 'which of these 64 cells match' - that's what the scan kernels do.
+// The rotated layers only need the cells that are actually in layer_any.
+void Board::rebuild_layers()
+{
+    static const char layer_chars[] = {'R', 'X', 'M', 'P', 'F'};
+    const int words = static_cast<int>(m_cells.size() / 64);
+    const ScanKernel kernel = best_scan_kernel();
+
+    for (int word = 0; word < words; ++word)
+    {
+        const char* cells = &m_cells[word * 64];
+        for (int layer = layer_robot; layer <= layer_flame; ++layer)
+        {
+            m_layers[layer][word] = match_cells(kernel, cells, layer_chars[layer]);
+        }
+        m_layers[layer_any][word] = ~(match_cells(kernel, cells, '.') | match_cells(kernel, cells, wall));
+    }
+
+    for (int orientation = by_col; orientation <= by_anti; ++orientation)
+    {
+        std::fill(m_any_by[orientation].begin(), m_any_by[orientation].end(), 0);
+    }
+    for (int word = 0; word < words; ++word)
+    {
+        for (std::uint64_t any = m_layers[layer_any][word]; any != 0; any &= any - 1)
+        {
+            int cell = word * 64 + __builtin_ctzll(any);
+            int row = row_of(cell), col = col_of(cell);
+            for (int orientation = by_col; orientation <= by_anti; ++orientation)
+            {
+                set_bit(m_any_by[orientation], oriented_index(static_cast<Orientation>(orientation), row, col), true);
+            }
+        }
+    }
+}
+
+// A cell's run is one more than the next cell's if the next cell is empty, so go through
+// the cells in the order that gets the next cell done first.
+void Board::rebuild_free_runs()
+{
+    const int cells = cell_count();
+    for (int direction = 1; direction <= 8; ++direction)
+    {
+        const int step = m_step[direction];
+        std::vector<std::uint16_t>& run = m_free_run[direction];
+        for (int i = 0; i < cells; ++i)
+        {
+            int index = (step > 0) ? cells - 1 - i : i;
+            if (m_cells[index] == wall)
+            {
+                run[index] = 0;
+                continue;
+            }
+            int next = index + step;
+            run[index] = (m_cells[next] == '.') ? run[next] + 1 : 0;
+        }
+    }
+}
+
+void Board::update(int index, int row, int col, char cell)
+{
+    char old_cell = m_cells[index];
+    if (old_cell == cell)
+    {
+        return;
+    }
+    m_cells[index] = cell;
+
+    int old_layer = layer_of(old_cell), new_layer = layer_of(cell);
+    if (old_layer != -1)
+        set_bit(m_layers[old_layer], index, false);
+    if (new_layer != -1)
+        set_bit(m_layers[new_layer], index, true);
+
+    bool was_any = (old_cell != '.' && old_cell != wall);
+    bool is_any = (cell != '.' && cell != wall);
+    if (was_any != is_any)
+    {
+        set_bit(m_layers[layer_any], index, is_any);
+        for (int orientation = by_col; orientation <= by_anti; ++orientation)
+        {
+            set_bit(m_any_by[orientation], oriented_index(static_cast<Orientation>(orientation), row, col), is_any);
+        }
+    }
+
+    // The cell filling up or emptying only changes the runs of the cells lined up behind it,
+    // back as far as the first one that isn't empty (its run ends here too, but nothing
+    // further back can see past it). That's one ray per direction, and each of the 8 does
+    // change: a run looking that way at this cell is in no other direction's table. Setting
+    // a cell to something that's just as empty or not (a robot dying, say) skips all of it.
+    if ((old_cell == '.') != (cell == '.'))
+    {
+        for (int direction = 1; direction <= 8; ++direction)
+        {
+            const int step = m_step[direction];
+            std::vector<std::uint16_t>& run = m_free_run[direction];
+            const int beyond = (cell == '.') ? run[index] + 1 : 0;
+            int distance = 0;
+            for (int behind = index - step; m_cells[behind] != wall; behind -= step)
+            {
+                run[behind] = static_cast<std::uint16_t>(distance + beyond);
+                if (m_cells[behind] != '.')
+                {
+                    break;
+                }
+                ++distance;
+            }
+        }
+    }
+}
+
+void Board::set_bit(std::vector<std::uint64_t>& bits, int index, bool on)
+{
+    std::uint64_t bit = std::uint64_t(1) << (index & 63);
+    if (on)
+        bits[index >> 6] |= bit;
+    else
+        bits[index >> 6] &= ~bit;
+}
+
+std::uint64_t Board::extract(const std::vector<std::uint64_t>& bits, int index, int count)
+{
+    int word = index >> 6, shift = index & 63;
+    std::uint64_t result = bits[word] >> shift;
+    if (shift != 0)
+        result |= bits[word + 1] << (64 - shift);
+    return (count >= 64) ? result : result & ((std::uint64_t(1) << count) - 1);
+}
+
+int Board::oriented_index(Orientation orientation, int row, int col) const
+{
+    switch (orientation)
+    {
+        case by_col:  return (col + 1) * m_height + (row + 1);
+        case by_diag: return (col - row + m_height - 1) * m_height + (row + 1);
+        case by_anti: return (row + col + 2) * m_height + (row + 1);
+        default:      return index(row, col);
+    }
+}
+
+std::uint64_t Board::any_bits(Orientation orientation, int oriented, int count) const
+{
+    return extract(orientation == by_row ? m_layers[layer_any] : m_any_by[orientation], oriented, count);
+}
@@ -0,0 +1,103 @@
+#ifndef __BOARD_H__
+#define __BOARD_H__
+
+#include <vector>
+#include <cstdint>
+
+// One bit layer per kind of thing on the board. layer_any is everything radar can see:
+// any cell that isn't empty or the wall.
+enum BoardLayer { layer_robot, layer_dead, layer_mound, layer_pit, layer_flame, layer_any, layer_count };
+
+// The arena grid. All the cells live in one flat buffer, one row after the other.
+// There is a one cell border of wall cells all the way around the playing area, so
+// a scan that steps one cell off the edge just reads a wall instead of needing four
+// bounds checks. Rows and columns still run 0..rows-1 and 0..cols-1 - the border
+// is row/col -1 and row/col == rows/cols.
+//
+// Next to the cells there is a bit layer for each BoardLayer, bit i is cell i, so scans
+// can test 64 cells at a time. layer_any is also kept along the columns, diagonals and
+// anti-diagonals ("rotated" layers), so a radar beam in any of the 8 directions is a
+// run of neighbouring bits.
+//
+// For moving, every cell also knows how many empty ('.') cells there are in a straight
+// line from it in each of the 8 movement directions before something is in the way.
+// set()/set_at() keep all of it up to date.
+class Board
+{
+public:
+    static constexpr char wall = '#';
+
+    // how the cells are numbered in a layer. by_row is the normal flat index.
+    enum Orientation { by_row, by_col, by_diag, by_anti };
+
+private:
+    int m_rows, m_cols;
+    int m_stride;               // cells per stored row (m_cols plus the two border cells)
+    int m_height;               // stored rows (m_rows plus the two border rows)
+    std::vector<char> m_cells;  // rounded up to whole 64 cell words, the extra cells are walls
+    std::vector<std::uint64_t> m_layers[layer_count];
+    std::vector<std::uint64_t> m_any_by[4];     // layer_any in each Orientation, [by_row] is unused
+    std::vector<std::uint16_t> m_free_run[9];   // by movement direction, [0] is unused
+    int m_step[9];                              // flat index offset of one step in each direction
+
+    void rebuild_free_runs();
+
+    void update(int index, int row, int col, char cell);
+    static void set_bit(std::vector<std::uint64_t>& bits, int index, bool on);
+    static std::uint64_t extract(const std::vector<std::uint64_t>& bits, int index, int count);
+
+public:
+    Board(int rows_in, int cols_in);
+
+    // set every playing cell to 'fill' and rebuild the wall around them
+    void reset(char fill = '.');
+
+    // work all the layers out again from the cells
+    void rebuild_layers();
+
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    int stride() const { return m_stride; }
+    int cell_count() const { return m_height * m_stride; }
+
+    // flat index of a cell - moving one row is +/- stride, one column is +/- 1
+    int index(int row, int col) const { return (row + 1) * m_stride + (col + 1); }
+    int row_of(int index) const { return index / m_stride - 1; }
+    int col_of(int index) const { return index % m_stride - 1; }
+
+    bool in_bounds(int row, int col) const
+    {
+        return row >= 0 && row < m_rows && col >= 0 && col < m_cols;
+    }
+
+    // row/col access. (row, col) may be one cell outside the arena, that is a wall.
+    char get(int row, int col) const { return m_cells[index(row, col)]; }
+    void set(int row, int col, char cell) { update(index(row, col), row, col, cell); }
+
+    // flat index access for the scan loops
+    char at(int index) const { return m_cells[index]; }
+    const char* data() const { return m_cells.data(); }
+    void set_at(int index, char cell) { update(index, row_of(index), col_of(index), cell); }
+
+    // which layer a cell character goes in, -1 for empty and the wall
+    static int layer_of(char cell);
+
+    // is this cell in the layer
+    bool bit(BoardLayer layer, int index) const { return (m_layers[layer][index >> 6] >> (index & 63)) & 1; }
+
+    // the layer bits of the 'count' cells (1..64) starting at flat index 'index', that cell in bit 0
+    std::uint64_t bits(BoardLayer layer, int index, int count) const { return extract(m_layers[layer], index, count); }
+
+    // the cell number of (row, col) in one of the rotated layers. Walking along a column,
+    // a diagonal (down-right) or an anti-diagonal (down-left) goes up by one per row.
+    int oriented_index(Orientation orientation, int row, int col) const;
+
+    // like bits(layer_any, ...) but numbered by oriented_index
+    std::uint64_t any_bits(Orientation orientation, int oriented, int count) const;
+
+    // how many empty cells in a row there are after cell 'index' going in 'direction'
+    // (1..8, the same numbering as the directions table). 0 if the next cell is taken.
+    int free_run(int index, int direction) const { return m_free_run[direction][index]; }
+};
+
+#endif
@@ -0,0 +1,173 @@
+#include "BoardRenderer.h"
+#include <charconv>
+#include <cstring>
+#include <algorithm>
+
+static const char title_start[] = "\n              =========== starting round ";
+static const char title_end[] = " ===========\n";
+static constexpr std::size_t title_room = sizeof(title_start) + sizeof(title_end) + 16;
+
+// 'value' right aligned in 'width' characters, like std::setw
+static void append_padded(std::string& text, const std::string& value, std::size_t width)
+{
+    if (value.size() < width)
+    {
+        text.append(width - value.size(), ' ');
+    }
+    text += value;
+}
+
+BoardRenderer::BoardRenderer(int rows, int cols, int view_rows, int view_cols)
+    : m_rows(rows), m_cols(cols),
+      m_view_rows(view_rows > 0 ? std::min(view_rows, rows) : rows),
+      m_view_cols(view_cols > 0 ? std::min(view_cols, cols) : cols),
+      m_label_width(std::max<int>(2, std::to_string(std::max(rows - 1, 0)).size())),
+      m_cell_width(std::max<int>(3, std::to_string(std::max(cols - 1, 0)).size() + 1)),
+      m_body_at(title_room), m_row_at(m_view_rows)
+{
+    m_frame.assign(title_room, ' ');
+
+    m_frame.append(m_label_width + 1, ' '); // Leading space for row indices
+    m_frame.append(m_view_cols * m_cell_width, ' ');
+    m_frame += '\n';
+
+    for (int row = 0; row < m_view_rows; ++row)
+    {
+        m_frame.append(m_label_width + 1, ' ');
+        m_row_at[row] = m_frame.size();
+        m_frame.append(m_view_cols * m_cell_width, ' ');
+        m_frame += '\n';
+    }
+}
+
+// the row and column numbers for a window at (top, left)
+void BoardRenderer::write_labels(int top, int left)
+{
+    std::string label;
+    char* header = m_frame.data() + m_body_at + m_label_width + 1;
+    for (int col = 0; col < m_view_cols; ++col)
+    {
+        label.clear();
+        append_padded(label, std::to_string(left + col), m_cell_width);
+        std::memcpy(header + col * m_cell_width, label.data(), m_cell_width);
+    }
+    for (int row = 0; row < m_view_rows; ++row)
+    {
+        label.clear();
+        append_padded(label, std::to_string(top + row), m_label_width);
+        std::memcpy(m_frame.data() + m_row_at[row] - m_label_width - 1, label.data(), m_label_width);
+    }
+    m_top = top;
+    m_left = left;
+}
+
+void BoardRenderer::center_on(int row, int col, int& top, int& left) const
+{
+    top = std::clamp(row - m_view_rows / 2, 0, m_rows - m_view_rows);
+    left = std::clamp(col - m_view_cols / 2, 0, m_cols - m_view_cols);
+}
+
+std::string_view BoardRenderer::render(int round, const char* cells, const int* occupant, int stride, int top, int left)
+{
+    top = std::clamp(top, 0, m_rows - m_view_rows);
+    left = std::clamp(left, 0, m_cols - m_view_cols);
+    if (top != m_top || left != m_left)
+    {
+        write_labels(top, left);
+    }
+    cells += top * stride + left;
+    occupant += top * stride + left;
+
+    // the title goes right up against the headers, however many digits the round has
+    char number[16];
+    std::size_t digits = static_cast<std::size_t>(std::to_chars(number, number + sizeof(number), round).ptr - number);
+    std::size_t title_at = m_body_at - (sizeof(title_start) - 1) - digits - (sizeof(title_end) - 1);
+    char* title = m_frame.data() + title_at;
+    std::memcpy(title, title_start, sizeof(title_start) - 1);
+    title += sizeof(title_start) - 1;
+    std::memcpy(title, number, digits);
+    std::memcpy(title + digits, title_end, sizeof(title_end) - 1);
+
+    bool changed = false;
+    for (int row = 0; row < m_view_rows; ++row)
+    {
+        char* out = m_frame.data() + m_row_at[row] + m_cell_width - 2;
+        const char* in = cells + row * stride;
+        const int* who = occupant + row * stride;
+        for (int col = 0; col < m_view_cols; ++col, out += m_cell_width)
+        {
+            char first, second;
+            cell_text(in[col], who[col], first, second);
+            changed |= (out[0] != first) | (out[1] != second);
+            out[0] = first;
+            out[1] = second;
+        }
+    }
+    m_changed = changed;    // the cells start out blank, so the first frame always counts
+
+    return std::string_view(m_frame.data() + title_at, m_frame.size() - title_at);
+}
+
+void format_board(int round, int rows, int cols, const char* cells, const int* occupant, int stride, std::string& text)
+{
+    BoardRenderer renderer(rows, cols);
+    text += renderer.render(round, cells, occupant, stride);
+}
+
+Minimap::Minimap(int rows, int cols, int map_cols, const char* cells, int stride)
+{
+    map_cols = std::clamp(map_cols, 1, std::max(cols, 1));
+    m_block_cols = (cols + map_cols - 1) / map_cols;
+    m_block_rows = 2 * m_block_cols;    // a character is about twice as tall as it is wide
+    m_map_cols = (cols + m_block_cols - 1) / m_block_cols;
+    m_map_rows = (rows + m_block_rows - 1) / m_block_rows;
+
+    m_terrain.assign(m_map_rows * m_map_cols, '.');
+    for (int row = 0; row < rows; ++row)
+    {
+        for (int col = 0; col < cols; ++col)
+        {
+            char cell = cells[row * stride + col];
+            if (cell != '.' && cell != 'R' && cell != 'X')
+            {
+                m_terrain[(row / m_block_rows) * m_map_cols + col / m_block_cols] = '+';
+            }
+        }
+    }
+    m_text.assign(m_map_rows * (m_map_cols + 1), '\n');
+}
+
+std::string_view Minimap::render(const std::vector<int>& row, const std::vector<int>& col, const std::vector<std::uint8_t>& alive,
+                                 int top, int left, int view_rows, int view_cols)
+{
+    auto at = [this](int map_row, int map_col) -> char& { return m_text[map_row * (m_map_cols + 1) + map_col]; };
+
+    for (int map_row = 0; map_row < m_map_rows; ++map_row)
+    {
+        std::memcpy(&at(map_row, 0), &m_terrain[map_row * m_map_cols], m_map_cols);
+    }
+
+    // blank out the empty blocks under the viewport
+    const int last_row = std::min((top + view_rows - 1) / m_block_rows, m_map_rows - 1);
+    const int last_col = std::min((left + view_cols - 1) / m_block_cols, m_map_cols - 1);
+    for (int map_row = top / m_block_rows; map_row <= last_row; ++map_row)
+    {
+        for (int map_col = left / m_block_cols; map_col <= last_col; ++map_col)
+        {
+            if (at(map_row, map_col) == '.')
+            {
+                at(map_row, map_col) = ' ';
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < row.size(); ++i)
+    {
+        char& block = at(row[i] / m_block_rows, col[i] / m_block_cols);
+        if (alive[i])
+            block = 'R';
+        else if (block != 'R')
+            block = 'x';
+    }
+    return m_text;
+}
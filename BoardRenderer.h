@@ -0,0 +1,99 @@
+#ifndef __BOARDRENDERER_H__
+#define __BOARDRENDERER_H__
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "TurnEvents.h"
+
+// Builds the board text the log prints at the start of a round, without allocating.
+//
+// Everything about the frame but the round number and the cells is the same every round,
+// so the column headers, row numbers and spacing are laid out once in the constructor and
+// render() only overwrites the two characters of each cell that can change. The frame
+// comes back as one piece of text, ready for a single write.
+//
+// The frame can be a window (viewport) onto a bigger board. Then only the window's cells
+// are looked at, and the row and column numbers are rewritten when the window moves.
+class BoardRenderer
+{
+public:
+    // a rows x cols board, shown view_rows x view_cols at a time (0: all of it)
+    BoardRenderer(int rows, int cols, int view_rows = 0, int view_cols = 0);
+
+    // Row r of the board starts at cells[r * stride]; occupant is laid out the same way and
+    // holds the robot index in each cell, or -1. The window's top left corner is (top, left),
+    // kept on the board. The text is good until the next render().
+    std::string_view render(int round, const char* cells, const int* occupant, int stride, int top = 0, int left = 0);
+
+    // whether any cell is different from the render() before (true for the first one)
+    bool changed() const { return m_changed; }
+
+    int view_rows() const { return m_view_rows; }
+    int view_cols() const { return m_view_cols; }
+    int top() const { return m_top; }       // the window the last render() showed
+    int left() const { return m_left; }
+
+    // the screen column (from 1) of the first of a window column's two characters
+    int cell_column(int col) const { return m_label_width + 1 + col * m_cell_width + m_cell_width - 1; }
+
+    // where a window centered on (row, col) has its top left corner
+    void center_on(int row, int col, int& top, int& left) const;
+
+private:
+    int m_rows, m_cols;
+    int m_view_rows, m_view_cols;
+    int m_label_width;                  // room for the row numbers
+    int m_cell_width;                   // room for the column numbers and a space - 3 up to 100 columns
+    int m_top = -1, m_left = -1;        // the window the numbers are written for
+    std::string m_frame;                // room for the title, then the headers and rows
+    std::size_t m_body_at;              // where the title ends and the headers start
+    std::vector<std::size_t> m_row_at;  // where each row's first cell is in m_frame
+    bool m_changed = false;
+
+    void write_labels(int top, int left);
+};
+
+// The two characters a cell shows after its leading space: " c", or "R!" with the robot's
+// symbol after an 'R' or 'X'. 'who' is the robot index in the cell, or -1.
+inline void cell_text(char cell, int who, char& first, char& second)
+{
+    first = ' ';
+    second = cell;
+    if ((cell == 'R' || cell == 'X') && who != -1)
+    {
+        first = cell;
+        second = robot_symbol(who);
+    }
+}
+
+// the board as one-off text, appended to 'text' (same layout as BoardRenderer)
+void format_board(int round, int rows, int cols, const char* cells, const int* occupant, int stride, std::string& text);
+
+// The whole board squeezed into a few characters, one per block of cells:
+//   R  a live robot        x  only dead ones
+//   +  an obstacle         .  nothing
+// with the blocks under the viewport left blank, so you can see where the window is.
+// The obstacles never move, so they're boiled down once when the minimap is made. After
+// that a render() only looks at the robots, whatever the size of the board.
+class Minimap
+{
+public:
+    Minimap(int rows, int cols, int map_cols, const char* cells, int stride);
+
+    // robot i is at (row[i], col[i]); the viewport is view_rows x view_cols at (top, left)
+    std::string_view render(const std::vector<int>& row, const std::vector<int>& col, const std::vector<std::uint8_t>& alive,
+                            int top, int left, int view_rows, int view_cols);
+
+    int map_rows() const { return m_map_rows; }
+
+private:
+    int m_block_rows, m_block_cols;     // board cells per minimap character
+    int m_map_rows, m_map_cols;
+    std::vector<char> m_terrain;        // the map with just the obstacles, m_map_rows x m_map_cols
+    std::string m_text;                 // the last render, a line per map row
+};
+
+#endif
@@ -0,0 +1,314 @@
+#include "CompressedLog.h"
+#include <zlib.h>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// fixed part of the member header: 10 bytes of gzip header, XLEN, then the 'RW' subfield id and length
+static constexpr std::size_t header_bytes = 10 + 2 + 4;
+static constexpr std::size_t rw_fixed_bytes = 12;
+static constexpr std::size_t max_queued_blocks = 4;
+
+static void put_u16(std::string& out, std::size_t at, std::uint32_t value)
+{
+    out[at] = static_cast<char>(value & 0xFF);
+    out[at + 1] = static_cast<char>((value >> 8) & 0xFF);
+}
+
+static void put_u32(std::string& out, std::size_t at, std::uint32_t value)
+{
+    put_u16(out, at, value & 0xFFFF);
+    put_u16(out, at + 2, value >> 16);
+}
+
+static std::uint32_t get_u16(const unsigned char* in)
+{
+    return in[0] | (in[1] << 8);
+}
+
+static std::uint32_t get_u32(const unsigned char* in)
+{
+    return get_u16(in) | (get_u16(in + 2) << 16);
+}
+
+CompressedLog::CompressedLog(int fd, std::size_t block_kb, int compression)
+    : m_fd(fd), m_block_bytes(block_kb * 1024), m_compression(compression)
+{
+    m_block.first_round = 0;
+    m_block.text.reserve(m_block_bytes + m_block_bytes / 4);
+    m_writer = std::thread(&CompressedLog::writer_loop, this);
+}
+
+CompressedLog::~CompressedLog()
+{
+    // whatever came after the last end_round() counts as one more round
+    if (m_block.text.size() > m_round_start)
+    {
+        end_round();
+    }
+    finish_block();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake_writer.notify_one();
+    m_writer.join();
+}
+
+void CompressedLog::write(std::string_view text)
+{
+    m_block.text.append(text);
+}
+
+void CompressedLog::end_round()
+{
+    m_block.round_sizes.push_back(static_cast<std::uint32_t>(m_block.text.size() - m_round_start));
+    m_round_start = m_block.text.size();
+    ++m_round;
+
+    if (m_block.text.size() >= m_block_bytes || m_block.round_sizes.size() >= max_rounds_per_block)
+    {
+        finish_block();
+    }
+}
+
+void CompressedLog::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_wake_producer.wait(lock, [this] { return m_queue.empty() && !m_writing; });
+}
+
+// hand the block to the writer and start a new one. Waits if the writer is falling behind.
+void CompressedLog::finish_block()
+{
+    if (m_block.round_sizes.empty())
+    {
+        return;
+    }
+
+    Block next;
+    next.first_round = m_round;
+    next.text.reserve(m_block.text.capacity());
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake_producer.wait(lock, [this] { return m_queue.size() < max_queued_blocks; });
+        m_queue.push_back(std::move(m_block));
+    }
+    m_wake_writer.notify_one();
+
+    m_block = std::move(next);
+    m_round_start = 0;
+}
+
+void CompressedLog::writer_loop()
+{
+    while (true)
+    {
+        Block block;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake_writer.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+            if (m_queue.empty())
+            {
+                return;     // stopping, and nothing left
+            }
+            block = std::move(m_queue.front());
+            m_queue.pop_front();
+            m_writing = true;
+        }
+        m_wake_producer.notify_all();
+
+        std::string member = make_member(block, m_compression);
+        for (std::size_t done = 0; done < member.size(); )
+        {
+            ssize_t written = ::write(m_fd, member.data() + done, member.size() - done);
+            if (written < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (written <= 0)
+            {
+                break;      // nowhere to put it
+            }
+            done += static_cast<std::size_t>(written);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_writing = false;
+        }
+        m_wake_producer.notify_all();
+    }
+}
+
+std::string CompressedLog::make_member(const Block& block, int compression)
+{
+    const std::size_t rounds = block.round_sizes.size();
+    const std::size_t rw_bytes = rw_fixed_bytes + 4 * rounds;
+    const std::size_t deflate_at = header_bytes + rw_bytes;
+
+    z_stream stream{};
+    deflateInit2(&stream, compression, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);   // raw deflate, we write the gzip framing
+
+    std::string member(deflate_at + deflateBound(&stream, block.text.size()) + 8, '\0');
+
+    // gzip header with FEXTRA set, no time stamp, unknown OS
+    const unsigned char gzip_header[10] = {0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 255};
+    std::memcpy(member.data(), gzip_header, sizeof(gzip_header));
+    put_u16(member, 10, static_cast<std::uint32_t>(4 + rw_bytes));
+    member[12] = 'R';
+    member[13] = 'W';
+    put_u16(member, 14, static_cast<std::uint32_t>(rw_bytes));
+    put_u32(member, header_bytes, block.first_round);
+    put_u32(member, header_bytes + 4, static_cast<std::uint32_t>(rounds));
+    for (std::size_t round = 0; round < rounds; ++round)
+    {
+        put_u32(member, header_bytes + rw_fixed_bytes + 4 * round, block.round_sizes[round]);
+    }
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(block.text.data()));
+    stream.avail_in = static_cast<uInt>(block.text.size());
+    stream.next_out = reinterpret_cast<Bytef*>(member.data() + deflate_at);
+    stream.avail_out = static_cast<uInt>(member.size() - deflate_at - 8);
+    deflate(&stream, Z_FINISH);
+    std::size_t end = deflate_at + stream.total_out;
+    deflateEnd(&stream);
+
+    // trailer: CRC and size of the uncompressed text
+    std::uint32_t crc = static_cast<std::uint32_t>(crc32(0, reinterpret_cast<const Bytef*>(block.text.data()), static_cast<uInt>(block.text.size())));
+    put_u32(member, end, crc);
+    put_u32(member, end + 4, static_cast<std::uint32_t>(block.text.size()));
+    member.resize(end + 8);
+
+    put_u32(member, header_bytes + 8, static_cast<std::uint32_t>(member.size()));
+    return member;
+}
+
+// read exactly 'count' bytes at 'offset', false at the end of the file
+static bool read_at(int fd, void* buffer, std::size_t count, off_t offset)
+{
+    char* out = static_cast<char*>(buffer);
+    while (count > 0)
+    {
+        ssize_t got = ::pread(fd, out, count, offset);
+        if (got < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (got <= 0)
+        {
+            return false;
+        }
+        out += got;
+        count -= static_cast<std::size_t>(got);
+        offset += got;
+    }
+    return true;
+}
+
+bool read_compressed_log(int fd, std::uint32_t from, std::uint32_t to,
+                         const std::function<void(std::uint32_t, std::string_view)>& visit)
+{
+    std::vector<unsigned char> extra;
+    std::string compressed, text;
+    off_t offset = 0;
+
+    struct stat file;
+    if (::fstat(fd, &file) != 0)
+    {
+        return false;
+    }
+    const off_t file_size = file.st_size;
+
+    unsigned char header[header_bytes];
+    while (read_at(fd, header, header_bytes, offset))
+    {
+        if (header[0] != 0x1f || header[1] != 0x8b || !(header[3] & 4) || header[12] != 'R' || header[13] != 'W')
+        {
+            return false;
+        }
+        std::size_t rw_bytes = get_u16(header + 14);
+        extra.resize(rw_bytes);
+        if (rw_bytes < rw_fixed_bytes || !read_at(fd, extra.data(), rw_bytes, offset + header_bytes))
+        {
+            return false;
+        }
+
+        std::uint32_t first_round = get_u32(&extra[0]);
+        std::uint32_t rounds = get_u32(&extra[4]);
+        std::uint32_t member_size = get_u32(&extra[8]);
+        std::uint32_t last_round = first_round + rounds - 1;
+
+        // a member has at least its header, the RW field and the trailer, all of it in the
+        // file, and a size for each of its rounds - anything else is a corrupt file, and a
+        // member_size of 0 would never get anywhere
+        std::size_t deflate_at = header_bytes + rw_bytes;
+        if (member_size < deflate_at + 8 || static_cast<off_t>(member_size) > file_size - offset || rounds > (rw_bytes - rw_fixed_bytes) / 4)
+        {
+            return false;
+        }
+
+        // only unpack the blocks that have rounds we want
+        if (rounds > 0 && last_round >= from && first_round <= to)
+        {
+            compressed.resize(member_size - deflate_at - 8);
+            unsigned char trailer[8];
+            if (!read_at(fd, compressed.data(), compressed.size(), offset + deflate_at) ||
+                !read_at(fd, trailer, 8, offset + member_size - 8))
+            {
+                return false;
+            }
+
+            // deflate can't shrink anything by more than about 1032 to 1, so a bigger size
+            // than that is a lie, and not worth allocating
+            std::uint32_t text_size = get_u32(trailer + 4);
+            if (text_size > (compressed.size() + 1) * 1032)
+            {
+                return false;
+            }
+            text.resize(text_size);
+            z_stream stream{};
+            if (inflateInit2(&stream, -15) != Z_OK)
+            {
+                return false;
+            }
+            stream.next_in = reinterpret_cast<Bytef*>(compressed.data());
+            stream.avail_in = static_cast<uInt>(compressed.size());
+            stream.next_out = reinterpret_cast<Bytef*>(text.data());
+            stream.avail_out = static_cast<uInt>(text.size());
+            int result = inflate(&stream, Z_FINISH);
+            inflateEnd(&stream);
+            if (result != Z_STREAM_END || stream.total_out != text_size ||
+                crc32(0, reinterpret_cast<const Bytef*>(text.data()), static_cast<uInt>(text.size())) != get_u32(trailer))
+            {
+                return false;
+            }
+
+            // the round sizes have to add up to the block
+            std::uint64_t total = 0;
+            for (std::uint32_t i = 0; i < rounds; ++i)
+            {
+                total += get_u32(&extra[rw_fixed_bytes + 4 * i]);
+            }
+            if (total != text_size)
+            {
+                return false;
+            }
+
+            std::size_t at = 0;
+            for (std::uint32_t i = 0; i < rounds; ++i)
+            {
+                std::uint32_t size = get_u32(&extra[rw_fixed_bytes + 4 * i]);
+                std::uint32_t round = first_round + i;
+                if (round >= from && round <= to)
+                {
+                    visit(round, std::string_view(text).substr(at, size));
+                }
+                at += size;
+            }
+        }
+        offset += member_size;
+    }
+    return true;
+}
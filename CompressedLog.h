@@ -0,0 +1,75 @@
+#ifndef __COMPRESSEDLOG_H__
+#define __COMPRESSEDLOG_H__
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstdint>
+#include <cstddef>
+
+// A gzip log file written one block at a time. Every block is its own gzip member, so the
+// file is still a normal .gz (zcat, zgrep and friends read it fine), and a background
+// thread does the compressing.
+//
+// Blocks only ever end between rounds, and each member's gzip header has an extra field
+// ('R','W') saying which rounds are in it and how big the member is:
+//
+//   u32 first_round, u32 round_count, u32 member_size, round_count x u32 round text size
+//
+// all little endian. A reader can hop from header to header without inflating anything
+// and only unpack the blocks holding the rounds it wants.
+class CompressedLog
+{
+public:
+    // rounds are counted by end_round(), starting at 0
+    CompressedLog(int fd, std::size_t block_kb = 64, int compression = 6);
+    ~CompressedLog();   // writes out the last block
+
+    CompressedLog(const CompressedLog&) = delete;
+    CompressedLog& operator=(const CompressedLog&) = delete;
+
+    void write(std::string_view text);
+    void end_round();
+    void flush();       // returns once every finished block is in the file
+
+    static constexpr std::size_t max_rounds_per_block = 4096;
+
+private:
+    struct Block {
+        std::uint32_t first_round;
+        std::vector<std::uint32_t> round_sizes;
+        std::string text;
+    };
+
+    int m_fd;
+    std::size_t m_block_bytes;
+    int m_compression;
+
+    Block m_block;                  // the one being filled
+    std::size_t m_round_start = 0;  // where the current round starts in m_block.text
+    std::uint32_t m_round = 0;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake_writer;
+    std::condition_variable m_wake_producer;
+    std::deque<Block> m_queue;      // finished blocks waiting for the writer
+    bool m_writing = false;         // the writer is busy with a block it took off the queue
+    bool m_stop = false;
+    std::thread m_writer;
+
+    void finish_block();
+    void writer_loop();
+    static std::string make_member(const Block& block, int compression);
+};
+
+// Calls visit(round, text) for every round from 'from' to 'to' in a compressed log, in
+// order, inflating only the blocks that have some of them in. False if the file isn't one.
+bool read_compressed_log(int fd, std::uint32_t from, std::uint32_t to,
+                         const std::function<void(std::uint32_t, std::string_view)>& visit);
+
+#endif
@@ -0,0 +1,350 @@
+#include "ForkedTournament.h"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <cstdio>
+#include <ctime>
+#include <csignal>
+#include <cerrno>
+#include <deque>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+
+static_assert(std::atomic<std::int64_t>::is_always_lock_free, "worker slots need lock free atomics in shared memory");
+
+static std::int64_t now_ms()
+{
+    struct timespec now;
+    ::clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<std::int64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
+ForkedTournament::ForkedTournament(const Tournament& tournament, int workers, int timeout_ms)
+    : m_tournament(tournament), m_workers(workers), m_timeout_ms(timeout_ms)
+{
+    if (m_workers <= 0)
+    {
+        m_workers = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+}
+
+std::vector<MatchResult> ForkedTournament::run(const std::vector<MatchJob>& jobs, const Tournament::Finished& finished)
+{
+    std::vector<MatchResult> results(jobs.size());
+    m_crashes = m_respawns = 0;
+    if (jobs.empty())
+    {
+        return results;
+    }
+
+    // the record size is fixed for the whole run, so it's set by the biggest roster
+    std::size_t max_roster = 0;
+    for (const MatchJob& job : jobs)
+    {
+        max_roster = std::max(max_roster, job.roster.size());
+    }
+    m_record_bytes = (sizeof(RecordHead) + max_roster * sizeof(std::int32_t) + 7) & ~static_cast<std::size_t>(7);
+    const std::size_t records_at = m_workers * sizeof(WorkerSlot);
+    const std::size_t bytes = records_at + jobs.size() * m_record_bytes;
+
+    void* region = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED || ::pipe2(m_done_pipe, O_CLOEXEC) != 0)
+    {
+        std::cerr << "Couldn't set up the shared tournament table." << std::endl;
+        if (region != MAP_FAILED)
+        {
+            ::munmap(region, bytes);
+        }
+        return results;
+    }
+    // it comes zeroed: every record is pending
+    m_region = static_cast<char*>(region);
+    m_slots = reinterpret_cast<WorkerSlot*>(m_region);
+    m_records = m_region + records_at;
+    m_job_sockets.assign(m_workers, -1);
+
+    // anything still in the parent's buffers would get written once per worker
+    std::cout.flush();
+    std::fflush(nullptr);
+
+    std::deque<std::size_t> queue;
+    for (std::size_t job = 0; job < jobs.size(); ++job)
+    {
+        queue.push_back(job);
+    }
+    std::vector<int> requeued(jobs.size(), 0);
+    std::vector<pid_t> pids(m_workers, -1);
+    std::vector<std::int64_t> assigned(m_workers, -1);      // the job each worker was handed, -1 for none
+    std::vector<std::int64_t> assigned_ms(m_workers, 0);    // when, on the monotonic clock
+    std::vector<bool> killed(m_workers, false);
+    std::vector<bool> reported(jobs.size(), false);
+    int running = 0;
+
+    // the next job down the worker's socket, or if there's none left, the socket closed so
+    // the worker leaves. If the worker's already gone the send fails, and the job goes back
+    // on the queue when it's reaped.
+    auto hand_out = [&](int w) {
+        if (queue.empty())
+        {
+            ::close(m_job_sockets[w]);
+            m_job_sockets[w] = -1;
+            return;
+        }
+        const std::int32_t job = static_cast<std::int32_t>(queue.front());
+        queue.pop_front();
+        assigned[w] = job;
+        assigned_ms[w] = now_ms();
+        (void)::send(m_job_sockets[w], &job, sizeof(job), MSG_NOSIGNAL);
+    };
+    auto pending_job = [&](int w) {
+        return assigned[w] >= 0 && record(assigned[w])->state.load(std::memory_order_acquire) == pending;
+    };
+    // the worker's job is over: tell 'finished' about it
+    auto collect = [&](int w) {
+        const std::size_t job = static_cast<std::size_t>(assigned[w]);
+        assigned[w] = -1;
+        if (finished && !reported[job])
+        {
+            reported[job] = true;
+            finished(job, read_record(job, jobs[job]));
+        }
+    };
+
+    for (int w = 0; w < m_workers && static_cast<std::size_t>(w) < jobs.size(); ++w)
+    {
+        pids[w] = spawn(w, jobs);
+        if (pids[w] > 0)
+        {
+            ++running;
+            hand_out(w);
+        }
+    }
+
+    while (running > 0)
+    {
+        // the workers say when they're done, so this wakes up for it
+        pollfd done{m_done_pipe[0], POLLIN, 0};
+        if (::poll(&done, 1, 2) > 0)
+        {
+            char drain[256];
+            (void)!::read(m_done_pipe[0], drain, sizeof(drain));
+        }
+        for (int w = 0; w < m_workers; ++w)
+        {
+            if (pids[w] > 0 && assigned[w] >= 0 && !pending_job(w))
+            {
+                collect(w);
+                if (!killed[w])
+                {
+                    hand_out(w);
+                }
+            }
+        }
+
+        int status = 0;
+        pid_t pid = ::waitpid(-1, &status, WNOHANG);
+        if (pid > 0)
+        {
+            auto found = std::find(pids.begin(), pids.end(), pid);
+            if (found == pids.end())
+            {
+                continue;
+            }
+            const int w = static_cast<int>(found - pids.begin());
+            pids[w] = -1;
+            killed[w] = false;
+            if (m_job_sockets[w] >= 0)
+            {
+                ::close(m_job_sockets[w]);
+                m_job_sockets[w] = -1;
+            }
+
+            // Gone with its job unfinished: if it had started on it, that's a crash or a
+            // hang and the match is forfeit; if it hadn't, the job is still to be played.
+            // Either way it's only ever the job this worker was handed.
+            if (pending_job(w))
+            {
+                const std::size_t job = static_cast<std::size_t>(assigned[w]);
+                if (m_slots[w].job.load(std::memory_order_acquire) == assigned[w] || requeued[job] >= 3)
+                {
+                    forfeit(w, job, jobs);
+                }
+                else
+                {
+                    ++requeued[job];
+                    queue.push_front(job);
+                }
+                ++m_crashes;
+            }
+            if (assigned[w] >= 0)
+            {
+                collect(w);
+            }
+            if (!queue.empty())
+            {
+                pids[w] = spawn(w, jobs);
+                if (pids[w] > 0)
+                {
+                    ++m_respawns;
+                    hand_out(w);
+                    continue;
+                }
+            }
+            --running;
+            continue;
+        }
+
+        // anybody stuck on its job for too long gets killed, and reaped above
+        const std::int64_t now = now_ms();
+        for (int w = 0; w < m_workers; ++w)
+        {
+            if (pids[w] > 0 && !killed[w] && pending_job(w) && now - assigned_ms[w] > m_timeout_ms)
+            {
+                ::kill(pids[w], SIGKILL);
+                killed[w] = true;
+            }
+        }
+    }
+
+    for (std::size_t job = 0; job < jobs.size(); ++job)
+    {
+        RecordHead* head = record(job);
+        // a job no worker could get through (they kept dying before starting it); nobody
+        // gets the blame
+        if (head->state.load(std::memory_order_acquire) == pending)
+        {
+            head->winner = -1;
+            head->forfeit = -1;
+        }
+        results[job] = read_record(job, jobs[job]);
+        if (finished && !reported[job])
+        {
+            finished(job, results[job]);
+        }
+    }
+
+    for (int& socket : m_job_sockets)
+    {
+        if (socket >= 0)
+        {
+            ::close(socket);
+        }
+        socket = -1;
+    }
+    ::close(m_done_pipe[0]);
+    ::close(m_done_pipe[1]);
+    m_done_pipe[0] = m_done_pipe[1] = -1;
+    ::munmap(m_region, bytes);
+    m_region = m_records = nullptr;
+    m_slots = nullptr;
+    return results;
+}
+
+MatchResult ForkedTournament::read_record(std::size_t job, const MatchJob& played)
+{
+    RecordHead* head = record(job);
+    MatchResult result;
+    result.winner = head->winner;
+    result.rounds = head->rounds;
+    result.forfeit = head->forfeit;
+    result.health.assign(record_health(job), record_health(job) + played.roster.size());
+    return result;
+}
+
+pid_t ForkedTournament::spawn(int worker, const std::vector<MatchJob>& jobs)
+{
+    int sockets[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) != 0)
+    {
+        std::cerr << "Couldn't start a tournament worker." << std::endl;
+        return -1;
+    }
+    m_slots[worker].job.store(-1, std::memory_order_relaxed);
+    m_slots[worker].turn.store(-1, std::memory_order_relaxed);
+    const pid_t parent = ::getpid();
+    pid_t pid = ::fork();
+    if (pid == 0)
+    {
+        // a worker left behind by a parent that was killed would go on writing results nobody reads
+        ::prctl(PR_SET_PDEATHSIG, SIGKILL);
+        if (::getppid() != parent)
+        {
+            ::_exit(0);
+        }
+        // only the parent may hold the other workers' sockets, or they'd never see them close
+        ::close(sockets[0]);
+        for (int socket : m_job_sockets)
+        {
+            if (socket >= 0)
+            {
+                ::close(socket);
+            }
+        }
+        ::close(m_done_pipe[0]);
+        worker_loop(worker, sockets[1], jobs);
+    }
+    ::close(sockets[1]);
+    if (pid < 0)
+    {
+        ::close(sockets[0]);
+        std::cerr << "Couldn't start a tournament worker." << std::endl;
+        return pid;
+    }
+    m_job_sockets[worker] = sockets[0];
+    return pid;
+}
+
+void ForkedTournament::worker_loop(int worker, int jobs_from, const std::vector<MatchJob>& jobs)
+{
+    WorkerSlot& slot = m_slots[worker];
+    while (true)
+    {
+        std::int32_t job = -1;
+        ssize_t got = ::recv(jobs_from, &job, sizeof(job), MSG_WAITALL);
+        if (got < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (got != sizeof(job) || job < 0 || static_cast<std::size_t>(job) >= jobs.size())
+        {
+            break;      // closed: no more jobs
+        }
+        slot.turn.store(-1, std::memory_order_relaxed);
+        slot.job.store(job, std::memory_order_release);
+
+        MatchResult result = m_tournament.play(jobs[job], &slot.turn, job);
+
+        RecordHead* head = record(job);
+        head->winner = result.winner;
+        head->rounds = result.rounds;
+        head->forfeit = -1;
+        std::copy(result.health.begin(), result.health.end(), record_health(job));
+        head->state.store(done, std::memory_order_release);
+
+        const std::int32_t who = worker;
+        (void)!::write(m_done_pipe[1], &who, sizeof(who));
+    }
+    // no destructors or stdio flushing - all of that belongs to the parent
+    ::_exit(0);
+}
+
+// the job 'worker' was playing when it went down goes to whoever's turn it was
+void ForkedTournament::forfeit(int worker, std::size_t job, const std::vector<MatchJob>& jobs)
+{
+    RecordHead* head = record(job);
+    if (head->state.load(std::memory_order_acquire) == done)
+    {
+        return;
+    }
+    const std::int32_t turn = m_slots[worker].job.load(std::memory_order_acquire) == static_cast<std::int32_t>(job)
+                            ? m_slots[worker].turn.load(std::memory_order_relaxed) : -1;
+    const std::vector<int>& roster = jobs[job].roster;
+    head->winner = -1;
+    head->forfeit = (turn >= 0 && static_cast<std::size_t>(turn) < roster.size()) ? roster[turn] : -1;
+    head->state.store(forfeited, std::memory_order_release);
+}
@@ -0,0 +1,80 @@
+#ifndef __FORKEDTOURNAMENT_H__
+#define __FORKEDTOURNAMENT_H__
+
+#include "Tournament.h"
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <sys/types.h>
+
+// Plays a tournament in worker processes instead of threads, so a robot that crashes or
+// never returns only takes its own match down.
+//
+// Before forking, the parent maps one shared memory region holding:
+//   workers   per worker: the job it's on, whose turn it is
+//   results   one fixed-size record per job: state, winner, rounds, forfeit, then
+//             health for up to max_roster robots
+// Workers fork after the robot libraries are loaded, so they all share the parent's copy
+// of the code and never compile or dlopen anything.
+//
+// The parent keeps the queue and hands each worker one job at a time down a socket of its
+// own; a worker says it's done on a pipe they all share, and the parent hands it the next.
+// So the parent always knows which job every worker has - none can go missing between a
+// worker taking it and saying so - and its clock for the timeout starts with that job.
+//
+// A worker that dies from a signal, or that spends longer than the timeout on its job (and
+// gets killed for it), forfeits that job and no other. The robot whose turn it was takes
+// the blame. A worker that dies before it even started its job hasn't played it, so the
+// job goes back on the queue. Either way a fresh worker is forked in its place.
+class ForkedTournament
+{
+public:
+    // workers 0: one per core. timeout_ms is how long one match may take.
+    ForkedTournament(const Tournament& tournament, int workers = 0, int timeout_ms = 10000);
+
+    // 'finished' hears about each match once it's over or forfeited, in this process
+    std::vector<MatchResult> run(const std::vector<MatchJob>& jobs, const Tournament::Finished& finished = nullptr);
+
+    int workers() const { return m_workers; }
+    int crashes() const { return m_crashes; }   // workers that died or hung in the last run()
+    int respawns() const { return m_respawns; }
+
+private:
+    const Tournament& m_tournament;
+    int m_workers;
+    int m_timeout_ms;
+    int m_crashes = 0;
+    int m_respawns = 0;
+
+    struct alignas(64) WorkerSlot {
+        std::atomic<std::int32_t> job;          // the job it has started on, -1 before the first
+        std::atomic<std::int32_t> turn;         // roster position whose code is running, or -1
+    };
+    enum RecordState : std::uint32_t { pending, done, forfeited };
+    struct RecordHead {
+        std::atomic<std::uint32_t> state;
+        std::int32_t winner, rounds, forfeit;
+    };
+
+    // the shared region, while run() is going
+    char* m_region = nullptr;
+    std::size_t m_record_bytes = 0;
+    WorkerSlot* m_slots = nullptr;
+    char* m_records = nullptr;
+
+    // the parent's end of each worker's job socket (-1 once it's closed), and the pipe the
+    // workers say they're done on
+    std::vector<int> m_job_sockets;
+    int m_done_pipe[2] = {-1, -1};
+
+    RecordHead* record(std::size_t job) { return reinterpret_cast<RecordHead*>(m_records + job * m_record_bytes); }
+    std::int32_t* record_health(std::size_t job) { return reinterpret_cast<std::int32_t*>(m_records + job * m_record_bytes + sizeof(RecordHead)); }
+
+    pid_t spawn(int worker, const std::vector<MatchJob>& jobs);
+    [[noreturn]] void worker_loop(int worker, int jobs_from, const std::vector<MatchJob>& jobs);
+    void forfeit(int worker, std::size_t job, const std::vector<MatchJob>& jobs);
+    MatchResult read_record(std::size_t job, const MatchJob& played);
+};
+
+#endif
@@ -0,0 +1,271 @@
+#include "FrameExport.h"
+#include <zlib.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+
+struct Color { std::uint8_t r, g, b; };
+
+// what's in a cell, by its character on the board
+static Color cell_color(char cell)
+{
+    switch (cell)
+    {
+        case 'M': return {139, 90, 43};     // mound
+        case 'P': return {25, 25, 25};      // pit
+        case 'F': return {255, 110, 0};     // flamethrower
+        case '.': return {235, 235, 225};
+        default:  return {255, 0, 255};     // something new - loud so it gets noticed
+    }
+}
+
+// a robot's color, by robot index - the same one every frame. There's one for each of the
+// 39 robot symbols (see robot_symbol): 13 hues spaced evenly round the color wheel, each
+// in three shades, so the robots next to each other in the roster differ in hue.
+static Color robot_color(int slot, bool dead)
+{
+    const int symbols = 39, hues = 13;
+    slot = ((slot % symbols) + symbols) % symbols;
+    const double hue = 6.0 * (slot % hues) / hues;     // in sixths of the wheel
+    const double value = (1.0 - 0.25 * (slot / hues)) * (dead ? 1.0 / 3 : 1.0);
+    const double rising = hue - static_cast<int>(hue), falling = 1.0 - rising;
+    double r = 0, g = 0, b = 0;
+    switch (static_cast<int>(hue))
+    {
+        case 0:  r = 1;       g = rising;  break;
+        case 1:  r = falling; g = 1;       break;
+        case 2:  g = 1;       b = rising;  break;
+        case 3:  g = falling; b = 1;       break;
+        case 4:  r = rising;  b = 1;       break;
+        default: r = 1;       b = falling; break;
+    }
+    auto level = [value](double part) { return static_cast<std::uint8_t>(255.0 * value * part + 0.5); };
+    return {level(r), level(g), level(b)};
+}
+
+FrameExporter::FrameExporter(const std::string& directory, int rows, int cols, Format format, int scale, int workers)
+    : m_directory(directory), m_rows(rows), m_cols(cols), m_format(format), m_scale(std::max(scale, 1))
+{
+    // nowhere to put them - every frame would fail, so say so straight away
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error || !std::filesystem::is_directory(directory, error))
+    {
+        m_ok = false;
+    }
+
+    if (workers <= 0)
+    {
+        workers = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    m_max_queued = 2 * static_cast<std::size_t>(workers);
+    for (int i = 0; i < workers; ++i)
+    {
+        m_workers.emplace_back(&FrameExporter::worker_loop, this);
+    }
+}
+
+FrameExporter::~FrameExporter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake_worker.notify_all();
+    for (std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+void FrameExporter::add_frame(int round, const char* cells, const int* occupant, int stride)
+{
+    Frame frame;
+    frame.round = round;
+    frame.cells.resize(m_rows * m_cols);
+    frame.occupant.resize(m_rows * m_cols);
+    for (int row = 0; row < m_rows; ++row)
+    {
+        std::memcpy(&frame.cells[row * m_cols], cells + row * stride, m_cols);
+        std::memcpy(&frame.occupant[row * m_cols], occupant + row * stride, m_cols * sizeof(int));
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake_producer.wait(lock, [this] { return m_queue.size() < m_max_queued; });
+        m_queue.push_back(std::move(frame));
+    }
+    m_wake_worker.notify_one();
+}
+
+void FrameExporter::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_wake_producer.wait(lock, [this] { return m_queue.empty() && m_busy == 0; });
+}
+
+void FrameExporter::worker_loop()
+{
+    while (true)
+    {
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake_worker.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+            if (m_queue.empty())
+            {
+                return;     // stopping, and nothing left
+            }
+            frame = std::move(m_queue.front());
+            m_queue.pop_front();
+            ++m_busy;
+        }
+        m_wake_producer.notify_all();
+
+        if (!write_frame(frame))
+        {
+            m_ok = false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_busy;
+        }
+        m_wake_producer.notify_all();
+    }
+}
+
+bool FrameExporter::write_frame(const Frame& frame)
+{
+    std::vector<std::uint8_t> pixels = rasterize(m_rows, m_cols, frame.cells.data(), frame.occupant.data(), m_cols, m_scale);
+    const int width = m_cols * m_scale, height = m_rows * m_scale;
+    std::string data = (m_format == png) ? encode_png(width, height, pixels) : encode_ppm(width, height, pixels);
+    if (data.empty())
+    {
+        return false;
+    }
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "/frame_%06d.%s", frame.round, m_format == png ? "png" : "ppm");
+    int fd = ::open((m_directory + name).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+    std::size_t done = 0;
+    while (done < data.size())
+    {
+        ssize_t written = ::write(fd, data.data() + done, data.size() - done);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            break;
+        }
+        done += static_cast<std::size_t>(written);
+    }
+    ::close(fd);
+    return done == data.size();
+}
+
+std::vector<std::uint8_t> FrameExporter::rasterize(int rows, int cols, const char* cells, const int* occupant, int stride, int scale)
+{
+    const std::size_t row_bytes = 3 * static_cast<std::size_t>(cols) * scale;
+    std::vector<std::uint8_t> pixels(row_bytes * rows * scale);
+    for (int row = 0; row < rows; ++row)
+    {
+        // one line of pixels for the row, then copies of it for the rest of the square
+        std::uint8_t* line = &pixels[row_bytes * row * scale];
+        for (int col = 0; col < cols; ++col)
+        {
+            char cell = cells[row * stride + col];
+            int who = occupant[row * stride + col];
+            Color color = ((cell == 'R' || cell == 'X') && who != -1) ? robot_color(who, cell == 'X') : cell_color(cell);
+            for (int x = 0; x < scale; ++x)
+            {
+                std::uint8_t* pixel = line + 3 * (col * scale + x);
+                pixel[0] = color.r;
+                pixel[1] = color.g;
+                pixel[2] = color.b;
+            }
+        }
+        for (int y = 1; y < scale; ++y)
+        {
+            std::memcpy(line + row_bytes * y, line, row_bytes);
+        }
+    }
+    return pixels;
+}
+
+std::string FrameExporter::encode_ppm(int width, int height, const std::vector<std::uint8_t>& pixels)
+{
+    std::string data = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+    data.append(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+    return data;
+}
+
+static void append_u32_big(std::string& out, std::uint32_t value)
+{
+    out += static_cast<char>(value >> 24);
+    out += static_cast<char>((value >> 16) & 0xFF);
+    out += static_cast<char>((value >> 8) & 0xFF);
+    out += static_cast<char>(value & 0xFF);
+}
+
+// length, type, data and the CRC of type and data
+static void append_png_chunk(std::string& out, const char* type, const std::string& data)
+{
+    append_u32_big(out, static_cast<std::uint32_t>(data.size()));
+    std::size_t crc_from = out.size();
+    out.append(type, 4);
+    out += data;
+    uLong crc = crc32(0, reinterpret_cast<const Bytef*>(out.data() + crc_from), static_cast<uInt>(out.size() - crc_from));
+    append_u32_big(out, static_cast<std::uint32_t>(crc));
+}
+
+// 8 bit RGB, no interlacing. Boards are big flat areas of the same color, so every line
+// uses the 'up' filter - a line that's the same as the one above is all zeros and
+// deflate squeezes it to almost nothing.
+std::string FrameExporter::encode_png(int width, int height, const std::vector<std::uint8_t>& pixels)
+{
+    const std::size_t row_bytes = 3 * static_cast<std::size_t>(width);
+    std::string filtered;
+    filtered.reserve((row_bytes + 1) * height);
+    for (int y = 0; y < height; ++y)
+    {
+        const std::uint8_t* line = &pixels[row_bytes * y];
+        filtered += static_cast<char>(y == 0 ? 0 : 2);
+        for (std::size_t i = 0; i < row_bytes; ++i)
+        {
+            filtered += static_cast<char>(y == 0 ? line[i] : static_cast<std::uint8_t>(line[i] - line[i - row_bytes]));
+        }
+    }
+
+    std::string compressed(compressBound(static_cast<uLong>(filtered.size())), '\0');
+    uLongf compressed_size = static_cast<uLongf>(compressed.size());
+    if (compress2(reinterpret_cast<Bytef*>(compressed.data()), &compressed_size,
+                  reinterpret_cast<const Bytef*>(filtered.data()), static_cast<uLong>(filtered.size()), 6) != Z_OK)
+    {
+        return "";
+    }
+    compressed.resize(compressed_size);
+
+    std::string header;
+    append_u32_big(header, static_cast<std::uint32_t>(width));
+    append_u32_big(header, static_cast<std::uint32_t>(height));
+    header += '\x08';   // bit depth
+    header += '\x02';   // truecolor
+    header.append(3, '\0');
+
+    std::string data("\x89PNG\r\n\x1a\n", 8);
+    append_png_chunk(data, "IHDR", header);
+    append_png_chunk(data, "IDAT", compressed);
+    append_png_chunk(data, "IEND", "");
+    return data;
+}
@@ -0,0 +1,74 @@
+#ifndef __FRAMEEXPORT_H__
+#define __FRAMEEXPORT_H__
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// Writes boards out as pictures, one file per frame: <directory>/frame_000042.ppm (or .png).
+// Every cell is a scale x scale square in a color for what's in it, robots in a color of
+// their own, one for each robot symbol (darker once they're dead).
+//
+// add_frame() only copies the cells; turning them into pixels, encoding and writing the
+// file happens on a pool of worker threads, so the game keeps going while they work. If the
+// workers fall too far behind add_frame() waits for them, so memory stays bounded.
+class FrameExporter
+{
+public:
+    enum Format { ppm, png };
+
+    FrameExporter(const std::string& directory, int rows, int cols, Format format, int scale = 8, int workers = 0);
+    ~FrameExporter();   // waits for every frame to be written
+
+    FrameExporter(const FrameExporter&) = delete;
+    FrameExporter& operator=(const FrameExporter&) = delete;
+
+    // Row r of the board starts at cells[r * stride]; occupant is laid out the same way and
+    // holds the robot index in each cell, or -1.
+    void add_frame(int round, const char* cells, const int* occupant, int stride);
+
+    // returns once every frame added so far is in its file
+    void flush();
+
+    // false if the directory couldn't be made or a file couldn't be written - once it's
+    // false it stays that way
+    bool ok() const { return m_ok; }
+
+    // a frame's pixels, 3 bytes (RGB) each, row after row
+    static std::vector<std::uint8_t> rasterize(int rows, int cols, const char* cells, const int* occupant, int stride, int scale);
+    static std::string encode_ppm(int width, int height, const std::vector<std::uint8_t>& pixels);
+    static std::string encode_png(int width, int height, const std::vector<std::uint8_t>& pixels);    // "" if it can't
+
+private:
+    struct Frame {
+        int round;
+        std::vector<char> cells;        // rows x cols, no padding
+        std::vector<int> occupant;
+    };
+
+    std::string m_directory;
+    int m_rows, m_cols;
+    Format m_format;
+    int m_scale;
+    std::size_t m_max_queued;
+    std::atomic<bool> m_ok{true};
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake_worker;
+    std::condition_variable m_wake_producer;
+    std::deque<Frame> m_queue;
+    int m_busy = 0;                     // workers in the middle of a frame
+    bool m_stop = false;
+    std::vector<std::thread> m_workers;
+
+    void worker_loop();
+    bool write_frame(const Frame& frame);
+};
+
+#endif
@@ -0,0 +1,267 @@
+#include "LiveView.h"
+#include <algorithm>
+#include <thread>
+#include <csignal>
+#include <cstdlib>
+#include <poll.h>
+#include <unistd.h>
+
+// where things are on the screen, 1-based: a status line, the round title, the column
+// headers, then the board rows with the lines under them (see BoardRenderer::cell_column).
+static constexpr int title_line = 2;
+static constexpr int first_board_line = 4;
+
+static void move_to(std::string& out, int line, int column)
+{
+    out += "\033[";
+    out += std::to_string(line);
+    out += ';';
+    out += std::to_string(column);
+    out += 'H';
+}
+
+// What the terminal was like before the view, for putting it back from a signal handler or
+// at exit, where the LiveView itself might not get the chance. Only async-signal-safe
+// calls in here.
+static struct termios saved_terminal;
+static volatile std::sig_atomic_t terminal_saved = 0;   // saved_terminal is worth restoring
+static volatile std::sig_atomic_t view_up = 0;          // the cursor might be hidden
+static struct sigaction old_sigint, old_sigterm;
+static int live_views = 0;      // the handlers go in with the first view and out with the last
+
+static void restore_terminal()
+{
+    if (terminal_saved)
+    {
+        ::tcsetattr(STDIN_FILENO, TCSANOW, &saved_terminal);
+    }
+    if (view_up)
+    {
+        static const char show_cursor[] = "\033[?25h\n";
+        ssize_t ignored = ::write(STDOUT_FILENO, show_cursor, sizeof(show_cursor) - 1);
+        (void)ignored;
+    }
+    terminal_saved = 0;
+    view_up = 0;
+}
+
+// put the terminal back, then go on with whatever the signal would have done
+static void restore_and_reraise(int signal)
+{
+    restore_terminal();
+    ::sigaction(signal, signal == SIGINT ? &old_sigint : &old_sigterm, nullptr);
+    ::raise(signal);
+}
+
+LiveView::LiveView(int rows, int cols, int view_rows, int view_cols, int tick_ms, bool keys)
+    : m_tick_ms(std::max(tick_ms, 0)), m_renderer(rows, cols, view_rows, view_cols),
+      m_shown(2 * m_renderer.view_rows() * m_renderer.view_cols()), m_next_tick(std::chrono::steady_clock::now()),
+      m_keys(keys && ::isatty(STDIN_FILENO))
+{
+    if (m_keys && ::tcgetattr(STDIN_FILENO, &m_saved_termios) == 0)
+    {
+        // keys as they're pressed, without echoing them
+        struct termios raw = m_saved_termios;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 0;
+        raw.c_cc[VTIME] = 0;
+        if (!terminal_saved)
+        {
+            saved_terminal = m_saved_termios;
+            terminal_saved = 1;
+        }
+        ::tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+    }
+    else
+    {
+        m_keys = false;
+    }
+
+    static bool at_exit = (std::atexit(restore_terminal) == 0);
+    (void)at_exit;
+    view_up = 1;
+    if (live_views++ == 0)
+    {
+        struct sigaction restore{};
+        restore.sa_handler = restore_and_reraise;
+        sigemptyset(&restore.sa_mask);
+        ::sigaction(SIGINT, &restore, &old_sigint);
+        ::sigaction(SIGTERM, &restore, &old_sigterm);
+    }
+}
+
+LiveView::~LiveView()
+{
+    if (--live_views == 0)
+    {
+        ::sigaction(SIGINT, &old_sigint, nullptr);
+        ::sigaction(SIGTERM, &old_sigterm, nullptr);
+        view_up = 0;
+    }
+    if (m_keys)
+    {
+        ::tcsetattr(STDIN_FILENO, TCSANOW, &m_saved_termios);
+        terminal_saved = 0;
+    }
+}
+
+void LiveView::draw(int round, const char* cells, const int* occupant, int stride, int top, int left,
+                    const std::vector<std::string>& lines, std::string& out)
+{
+    std::string_view frame = m_renderer.render(round, cells, occupant, stride, top, left);
+    top = m_renderer.top();     // kept on the board
+    left = m_renderer.left();
+    if (!m_drawn || top != m_top || left != m_left)
+    {
+        // the whole frame, hiding the cursor so it doesn't jump around the board
+        out += "\033[?25l\033[2J\033[H";
+        out += frame;
+        std::fill(m_shown.begin(), m_shown.end(), 0);
+        m_shown_lines.clear();
+        m_shown_status.clear();
+        m_drawn = true;
+        m_top = top;
+        m_left = left;
+    }
+    else
+    {
+        move_to(out, title_line, 1);
+        out += frame.substr(1, frame.find('\n', 1) - 1);   // the title, without the blank line before it
+        out += "\033[K";
+    }
+
+    const int view_rows = m_renderer.view_rows(), view_cols = m_renderer.view_cols();
+    cells += top * stride + left;
+    occupant += top * stride + left;
+    for (int row = 0; row < view_rows; ++row)
+    {
+        for (int col = 0; col < view_cols; ++col)
+        {
+            char first, second;
+            cell_text(cells[row * stride + col], occupant[row * stride + col], first, second);
+            char* shown = &m_shown[2 * (row * view_cols + col)];
+            if (shown[0] == first && shown[1] == second)
+            {
+                continue;
+            }
+            if (shown[1] != 0)  // the first frame already put it there
+            {
+                move_to(out, first_board_line + row, m_renderer.cell_column(col));
+                out += first;
+                out += second;
+            }
+            shown[0] = first;
+            shown[1] = second;
+        }
+    }
+
+    m_shown_lines.resize(lines.size());
+    for (std::size_t line = 0; line < lines.size(); ++line)
+    {
+        if (lines[line] != m_shown_lines[line])
+        {
+            move_to(out, below_line(static_cast<int>(line)), 1);
+            out += lines[line];
+            out += "\033[K";
+            m_shown_lines[line] = lines[line];
+        }
+    }
+
+    std::string now = status(round);
+    if (now != m_shown_status)
+    {
+        move_to(out, 1, 1);
+        out += now;
+        out += "\033[K";
+        m_shown_status = now;
+    }
+}
+
+void LiveView::close(std::string& out)
+{
+    move_to(out, below_line(static_cast<int>(m_shown_lines.size())), 1);
+    out += "\033[?25h\n";
+}
+
+std::string LiveView::status(int round) const
+{
+    std::string text = "round " + std::to_string(round) + "  ";
+    text += m_tick_ms == 0 ? std::string("full speed") : std::to_string(m_tick_ms) + " ms a round";
+    if (m_keys)
+    {
+        text += m_paused ? "  PAUSED (p go on, n step)" : "  (p pause, +/- speed, f full speed)";
+    }
+    return text;
+}
+
+void LiveView::wait_for_tick()
+{
+    using namespace std::chrono;
+    m_next_tick += milliseconds(m_tick_ms);
+    while (true)
+    {
+        read_keys(0);
+        if (m_paused)
+        {
+            if (m_step)
+            {
+                m_step = false;
+                break;
+            }
+            read_keys(100);
+            m_next_tick = steady_clock::now();  // going on again starts a fresh tick
+            continue;
+        }
+
+        auto now = steady_clock::now();
+        if (now >= m_next_tick)
+        {
+            // more than a tick behind (a slow round, or the speed went up) - don't rush to catch up
+            if (now - m_next_tick > milliseconds(m_tick_ms))
+            {
+                m_next_tick = now;
+            }
+            break;
+        }
+        read_keys(static_cast<int>(ceil<milliseconds>(m_next_tick - now).count()));
+    }
+}
+
+void LiveView::handle_key(char key)
+{
+    switch (key)
+    {
+        case 'p':
+        case ' ': m_paused = !m_paused; break;
+        case 'n': m_step = m_paused; break;
+        case '+': m_tick_ms /= 2; break;
+        case '-': m_tick_ms = m_tick_ms == 0 ? 10 : std::min(m_tick_ms * 2, 60000); break;
+        case 'f': m_tick_ms = 0; break;
+        default: break;
+    }
+}
+
+// waits up to wait_ms for a key, and handles everything that's been typed
+void LiveView::read_keys(int wait_ms)
+{
+    if (!m_keys)
+    {
+        if (wait_ms > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(wait_ms));
+        }
+        return;
+    }
+
+    struct pollfd in = {STDIN_FILENO, POLLIN, 0};
+    if (::poll(&in, 1, wait_ms) <= 0)
+    {
+        return;
+    }
+    char keys[16];
+    ssize_t got = ::read(STDIN_FILENO, keys, sizeof(keys));
+    for (ssize_t i = 0; i < got; ++i)
+    {
+        handle_key(keys[i]);
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef __LIVEVIEW_H__
+#define __LIVEVIEW_H__
+
+#include "BoardRenderer.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <termios.h>
+
+// The board on the terminal while the game runs (-live=true).
+//
+// The first frame is drawn whole. After that the view remembers what is on the screen and
+// only sends cursor moves and new text for the cells and stats lines that changed, so a
+// round where two robots move is a few dozen bytes instead of a full screen.
+//
+// Rounds are paced off the monotonic clock, one every tick_ms (0 runs as fast as it can).
+// With keys on, the terminal is put in raw mode while the view exists and these work
+// between rounds:
+//   p or space  pause / go on
+//   n           one more round while paused
+//   + and -     twice as fast / twice as slow
+//   f           as fast as possible
+// The terminal also gets put back (and the cursor shown again) if the program exits, or
+// is stopped with SIGINT or SIGTERM, while a view is up.
+class LiveView
+{
+public:
+    // a rows x cols board, view_rows x view_cols of it on the screen (0: all of it)
+    LiveView(int rows, int cols, int view_rows, int view_cols, int tick_ms, bool keys);
+    ~LiveView();    // puts the terminal back
+
+    LiveView(const LiveView&) = delete;
+    LiveView& operator=(const LiveView&) = delete;
+
+    // Screen updates for the board at the start of 'round' and the lines under it (a stats
+    // line per robot, the minimap), appended to 'out'. Cells and occupant are laid out like
+    // BoardRenderer wants them, and (top, left) is the corner of the viewport. Moving the
+    // viewport redraws the whole board.
+    void draw(int round, const char* cells, const int* occupant, int stride, int top, int left,
+              const std::vector<std::string>& lines, std::string& out);
+
+    // Moves the cursor below everything that was drawn, so normal text can follow.
+    void close(std::string& out);
+
+    // Waits until the next round is due, handling keys while it does.
+    void wait_for_tick();
+
+    int tick_ms() const { return m_tick_ms; }
+    bool paused() const { return m_paused; }
+    void handle_key(char key);
+
+private:
+    int m_tick_ms;
+    bool m_paused = false;
+    bool m_step = false;        // let one round through while paused
+    BoardRenderer m_renderer;   // for the first, full frame
+    std::vector<char> m_shown;  // the two characters of each viewport cell that are on the screen
+    std::vector<std::string> m_shown_lines;
+    std::string m_shown_status;
+    bool m_drawn = false;
+    int m_top = 0, m_left = 0;  // the viewport on the screen
+    std::chrono::steady_clock::time_point m_next_tick;
+
+    bool m_keys;
+    struct termios m_saved_termios;
+
+    int below_line(int line) const { return m_renderer.view_rows() + 4 + line; }   // 1-based screen lines
+    std::string status(int round) const;
+    void read_keys(int wait_ms);
+};
+
+#endif
@@ -0,0 +1,139 @@
+#include "LogSink.h"
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+
+LogSink::LogSink(int fd, bool enabled, Flush policy, std::size_t flush_kb, std::size_t capacity)
+    : m_fd(fd), m_enabled(enabled && fd >= 0), m_policy(policy), m_flush_bytes(flush_kb * 1024)
+{
+    if (m_enabled)
+    {
+        m_ring.resize(std::max<std::size_t>(capacity, 64));
+        m_writer = std::thread(&LogSink::writer_loop, this);
+    }
+}
+
+LogSink::~LogSink()
+{
+    if (!m_enabled)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        m_wanted = m_head.load(std::memory_order_relaxed);
+    }
+    m_wake_writer.notify_one();
+    m_writer.join();
+}
+
+void LogSink::write(std::string_view text)
+{
+    if (!m_enabled)
+    {
+        return;
+    }
+
+    const std::size_t size = m_ring.size();
+    while (!text.empty())
+    {
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        std::size_t space = size - (head - m_tail.load(std::memory_order_acquire));
+
+        // full - get the writer going and wait for it to make some room
+        if (space == 0)
+        {
+            kick();
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake_producer.wait(lock, [&] { return m_tail.load(std::memory_order_acquire) != head - size; });
+            continue;
+        }
+
+        std::size_t count = std::min(space, text.size());
+        std::size_t at = head % size;
+        std::size_t first = std::min(count, size - at);
+        std::memcpy(&m_ring[at], text.data(), first);
+        std::memcpy(&m_ring[0], text.data() + first, count - first);
+        m_head.store(head + count, std::memory_order_release);
+        text.remove_prefix(count);
+    }
+
+    if (m_policy == every_kb && m_head.load(std::memory_order_relaxed) - m_kicked >= m_flush_bytes)
+    {
+        kick();
+    }
+}
+
+void LogSink::end_round()
+{
+    if (m_enabled && m_policy == every_round)
+    {
+        kick();
+    }
+}
+
+void LogSink::flush()
+{
+    if (!m_enabled)
+    {
+        return;
+    }
+    kick();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_wake_producer.wait(lock, [&] { return m_tail.load(std::memory_order_acquire) >= m_wanted; });
+}
+
+// tell the writer there's something to do
+void LogSink::kick()
+{
+    m_kicked = m_head.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_wanted = std::max(m_wanted, m_kicked);
+    }
+    m_wake_writer.notify_one();
+}
+
+void LogSink::writer_loop()
+{
+    const std::size_t size = m_ring.size();
+    std::size_t tail = 0;
+
+    while (true)
+    {
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake_writer.wait(lock, [&] { return m_stop || m_wanted > tail; });
+            stopping = m_stop;
+        }
+
+        // take everything that's there by now, not just what we were asked for
+        std::size_t head = m_head.load(std::memory_order_acquire);
+        while (tail < head)
+        {
+            std::size_t at = tail % size;
+            std::size_t count = std::min(head - tail, size - at);
+            ssize_t written = ::write(m_fd, &m_ring[at], count);
+            if (written < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            // nowhere to put it, so drop it rather than spin
+            tail += (written > 0) ? static_cast<std::size_t>(written) : count;
+            m_tail.store(tail, std::memory_order_release);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_wake_producer.notify_all();
+        }
+
+        if (stopping && tail == m_head.load(std::memory_order_acquire))
+        {
+            return;
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef __LOGSINK_H__
+#define __LOGSINK_H__
+
+#include <string_view>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstddef>
+
+// One place log text goes (the console, the log file). write() just copies the text into
+// a ring buffer; a background thread takes it out again and hands it to the OS in big
+// write() calls, so the game never waits on I/O unless the ring fills up.
+//
+// When the writer thread gets woken up is the flush policy:
+//   every_round - at each end_round()
+//   every_kb    - whenever flush_kb kilobytes are waiting
+//   at_exit     - only when the ring is full, on flush() and when the sink goes away
+// Text written to a disabled sink is dropped on the floor.
+class LogSink
+{
+public:
+    enum Flush { every_round, every_kb, at_exit };
+
+    LogSink(int fd, bool enabled, Flush policy, std::size_t flush_kb = 64, std::size_t capacity = 1 << 20);
+    ~LogSink();     // writes out whatever is left
+
+    LogSink(const LogSink&) = delete;
+    LogSink& operator=(const LogSink&) = delete;
+
+    bool enabled() const { return m_enabled; }
+
+    void write(std::string_view text);
+    void end_round();
+    void flush();   // returns once everything written so far is with the OS
+
+private:
+    int m_fd;
+    bool m_enabled;
+    Flush m_policy;
+    std::size_t m_flush_bytes;
+
+    // Single producer, single consumer. m_head only moves in write(), m_tail only in the
+    // writer thread. Both count bytes ever written, the ring position is that mod size.
+    std::vector<char> m_ring;
+    std::atomic<std::size_t> m_head{0};
+    std::atomic<std::size_t> m_tail{0};
+    std::size_t m_kicked = 0;       // m_head the last time the writer was woken up
+
+    // just for sleeping - the data itself doesn't need the lock
+    std::mutex m_mutex;
+    std::condition_variable m_wake_writer;
+    std::condition_variable m_wake_producer;
+    std::size_t m_wanted = 0;       // the writer should get m_tail up to here
+    bool m_stop = false;
+
+    std::thread m_writer;
+
+    void kick();
+    void writer_loop();
+};
+
+#endif
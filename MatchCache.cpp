@@ -0,0 +1,178 @@
+#include "MatchCache.h"
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <filesystem>
+#include <atomic>
+#include <cstdio>
+#include <unistd.h>
+
+static std::string hex(std::uint64_t value)
+{
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value));
+    return text;
+}
+
+// 64 bit FNV-1a
+std::uint64_t MatchCache::hash(const void* bytes, std::size_t count, std::uint64_t seed)
+{
+    const unsigned char* byte = static_cast<const unsigned char*>(bytes);
+    std::uint64_t h = seed;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        h ^= byte[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+std::uint64_t MatchCache::hash_file(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        return 0;
+    }
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return hash(contents.data(), contents.size());
+}
+
+MatchCache::MatchCache(const std::string& directory, const std::vector<RobotFactory>& factories, int round_limit)
+    : m_directory(directory), m_factories(factories), m_round_limit(round_limit)
+{
+    std::uint64_t parts[2] = {hash_file("RobotBase.h"), hash_file("RobotBase.cpp")};
+    m_base_hash = hash(parts, sizeof(parts));
+    for (const RobotFactory& factory : m_factories)
+    {
+        m_source_hash.push_back(hash_file("Robot_" + factory.name + ".cpp"));
+    }
+}
+
+std::string MatchCache::inputs(const MatchJob& job) const
+{
+    std::ostringstream material;
+    material << "rules " << match_rules << " rounds " << m_round_limit << " size " << job.rows << "x" << job.cols
+             << " seed " << job.seed << " base " << hex(m_base_hash);
+    for (int who : job.roster)
+    {
+        material << " robot " << m_factories[who].name << " " << hex(m_source_hash[who]);
+    }
+    return material.str();
+}
+
+std::string MatchCache::key(const MatchJob& job) const
+{
+    const std::string text = inputs(job);
+    return hex(hash(text.data(), text.size()));
+}
+
+std::string MatchCache::path(const MatchJob& job) const
+{
+    const std::string name = key(job);
+    return m_directory + "/" + name.substr(0, 2) + "/" + name.substr(2);
+}
+
+// "inputs <the inputs>" then "match <winner slot> <rounds> <health>..." - the winner is a
+// roster position, -1 for nobody
+bool MatchCache::load(const MatchJob& job, MatchResult& result) const
+{
+    std::ifstream in(path(job));
+    std::string line;
+    if (!std::getline(in, line) || line != "inputs " + inputs(job))
+    {
+        return false;
+    }
+    std::string tag;
+    int winner = -1, rounds = 0;
+    if (!(in >> tag >> winner >> rounds) || tag != "match" || winner < -1 || winner >= static_cast<int>(job.roster.size()))
+    {
+        return false;
+    }
+    std::vector<int> health(job.roster.size());
+    for (int& h : health)
+    {
+        if (!(in >> h))
+        {
+            return false;
+        }
+    }
+    result.winner = winner >= 0 ? job.roster[winner] : -1;
+    result.rounds = rounds;
+    result.health = health;
+    result.forfeit = -1;
+    return true;
+}
+
+void MatchCache::store(const MatchJob& job, const MatchResult& result) const
+{
+    if (result.forfeit >= 0 || result.health.size() != job.roster.size())
+    {
+        return;
+    }
+    int winner = -1;
+    for (std::size_t slot = 0; slot < job.roster.size() && result.winner >= 0; ++slot)
+    {
+        if (job.roster[slot] == result.winner)
+        {
+            winner = static_cast<int>(slot);
+            break;
+        }
+    }
+
+    // the same match can be finishing on two threads at once
+    static std::atomic<std::uint64_t> stores{0};
+    const std::string file = path(job);
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(file).parent_path(), error);
+    const std::string temporary = file + ".tmp" + std::to_string(::getpid()) + "." + std::to_string(stores.fetch_add(1));
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        out << "inputs " << inputs(job) << "\n" << "match " << winner << " " << result.rounds;
+        for (int h : result.health)
+        {
+            out << " " << h;
+        }
+        out << "\n";
+        if (!out.flush())
+        {
+            out.close();
+            std::remove(temporary.c_str());
+            return;
+        }
+    }
+    if (std::rename(temporary.c_str(), file.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+    }
+}
+
+std::vector<MatchResult> MatchCache::run(const std::vector<MatchJob>& jobs, const Play& play)
+{
+    std::vector<MatchResult> results(jobs.size());
+    std::vector<MatchJob> missing;
+    std::vector<std::size_t> missing_at;
+    for (std::size_t job = 0; job < jobs.size(); ++job)
+    {
+        if (!load(jobs[job], results[job]))
+        {
+            missing.push_back(jobs[job]);
+            missing_at.push_back(job);
+        }
+    }
+    m_reused = jobs.size() - missing.size();
+    m_recomputed = missing.size();
+    if (missing.empty())
+    {
+        return results;
+    }
+
+    std::vector<MatchResult> played = play(missing, missing_at, [&](std::size_t job, const MatchResult& result) {
+        store(missing[job], result);
+    });
+    for (std::size_t i = 0; i < missing.size() && i < played.size(); ++i)
+    {
+        results[missing_at[i]] = played[i];
+    }
+    return results;
+}
@@ -0,0 +1,68 @@
+#ifndef __MATCHCACHE_H__
+#define __MATCHCACHE_H__
+
+#include "Tournament.h"
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+// Remembers match results on disk, so a tournament run again only plays the matches whose
+// inputs changed.
+//
+// A match's inputs are everything that decides how it goes:
+//   the rules version (match_rules below), the round limit, the board size and seed,
+//   RobotBase.h and RobotBase.cpp, and for each roster position the robot's name and the
+//   contents of its Robot_<name>.cpp
+// so editing one robot only loses the matches it's in. The seed decides the obstacles, so
+// a change to how they're laid out needs match_rules bumped like any other rule change.
+//
+// The key is a 64 bit hash of the inputs, and the result is kept in
+// <directory>/<first two hex digits of the key>/<the rest>, with the inputs written out in
+// front of it: a result is only handed back if they're the same, so two matches whose
+// keys collide just play again. The winner and health are by roster position. Each result
+// is written as soon as its match is over, to a temporary file that's then renamed so a
+// reader never sees half of one.
+//
+// Forfeits aren't kept: a robot that hung might not next time.
+class MatchCache
+{
+public:
+    // bump it when a change to the game changes how matches come out
+    static const int match_rules = 1;
+
+    // the robot sources are hashed now, from the current directory
+    MatchCache(const std::string& directory, const std::vector<RobotFactory>& factories, int round_limit);
+
+    std::string inputs(const MatchJob& job) const;
+    std::string key(const MatchJob& job) const;     // 16 hex digits
+    bool load(const MatchJob& job, MatchResult& result) const;
+    void store(const MatchJob& job, const MatchResult& result) const;   // from any thread
+
+    // the results of 'jobs': the ones in the cache from there, and the others from 'play'.
+    // It's handed just the missing jobs, where each of them is in 'jobs', and a callback to
+    // give each result to as soon as its match is over (numbered like the jobs it was
+    // handed), which keeps it for next time. A run cut short keeps what got played.
+    using Play = std::function<std::vector<MatchResult>(const std::vector<MatchJob>& jobs, const std::vector<std::size_t>& positions,
+                                                        const Tournament::Finished& finished)>;
+    std::vector<MatchResult> run(const std::vector<MatchJob>& jobs, const Play& play);
+
+    std::size_t reused() const { return m_reused; }          // in the last run()
+    std::size_t recomputed() const { return m_recomputed; }
+
+    static std::uint64_t hash(const void* bytes, std::size_t count, std::uint64_t seed = 0xcbf29ce484222325ull);
+    static std::uint64_t hash_file(const std::string& path);     // 0 if it can't be read
+
+private:
+    std::string m_directory;
+    const std::vector<RobotFactory>& m_factories;
+    int m_round_limit;
+    std::uint64_t m_base_hash;                  // RobotBase.h and RobotBase.cpp
+    std::vector<std::uint64_t> m_source_hash;   // by factory
+    std::size_t m_reused = 0, m_recomputed = 0;
+
+    std::string path(const MatchJob& job) const;
+};
+
+#endif
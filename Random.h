@@ -0,0 +1,39 @@
+#ifndef __RANDOM_H__
+#define __RANDOM_H__
+
+#include <cstdint>
+
+// A counter based random number generator: the n-th number of a stream is a hash of
+// (seed, stream, n). Streams with different numbers never share or disturb each other's
+// numbers, so what one part of the game draws doesn't change what another part gets, and
+// two Arenas can each have their own without any locking.
+class RandomStream
+{
+public:
+    RandomStream(std::uint32_t seed = 0, std::uint64_t stream = 0)
+        : m_key(mix((static_cast<std::uint64_t>(seed) << 32) ^ mix(stream + 0x9E3779B97F4A7C15ull))) {}
+
+    std::uint32_t next() { return static_cast<std::uint32_t>(mix(m_key + 0x9E3779B97F4A7C15ull * ++m_counter) >> 32); }
+
+    // 0 .. n - 1, for n > 0
+    int below(int n) { return static_cast<int>((static_cast<std::uint64_t>(next()) * static_cast<std::uint32_t>(n)) >> 32); }
+
+    std::uint64_t drawn() const { return m_counter; }
+
+private:
+    std::uint64_t m_key;
+    std::uint64_t m_counter = 0;
+
+    // the SplitMix64 finalizer
+    static std::uint64_t mix(std::uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+};
+
+// what each of an Arena's streams is for; robot n's damage rolls are random_damage + n
+enum RandomStreamId : std::uint64_t { random_map = 1, random_placement = 2, random_damage = 16 };
+
+#endif
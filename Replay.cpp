@@ -0,0 +1,475 @@
+#include "Replay.h"
+#include "RobotBase.h"
+#include "BoardRenderer.h"
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char replay_magic[8] = {'R', 'W', 'R', 'E', 'P', 'L', 'A', 'Y'};
+static const char index_magic[8] = {'R', 'W', 'I', 'N', 'D', 'E', 'X', '1'};
+static constexpr std::uint32_t replay_version = 1;
+static constexpr std::size_t trailer_bytes = 32;
+static constexpr std::size_t event_bytes = 16;
+
+enum RecordKind : std::uint8_t { delta_record, keyframe_record, end_record };
+
+static void append_u8(std::string& out, std::uint32_t value) { out += static_cast<char>(value & 0xFF); }
+static void append_u16(std::string& out, std::uint32_t value) { append_u8(out, value); append_u8(out, value >> 8); }
+static void append_u32(std::string& out, std::uint32_t value) { append_u16(out, value & 0xFFFF); append_u16(out, value >> 16); }
+static void append_u64(std::string& out, std::uint64_t value) { append_u32(out, value & 0xFFFFFFFF); append_u32(out, value >> 32); }
+
+static std::uint32_t get_u16(const unsigned char* in) { return in[0] | (in[1] << 8); }
+static std::uint32_t get_u32(const unsigned char* in) { return get_u16(in) | (get_u16(in + 2) << 16); }
+static std::uint64_t get_u64(const unsigned char* in) { return get_u32(in) | (std::uint64_t(get_u32(in + 4)) << 32); }
+
+// stand in for a robot that was in the match, so the event formatter has a name to print
+class ReplayRobot : public RobotBase
+{
+public:
+    ReplayRobot(const std::string& name, WeaponType weapon) : RobotBase(2, 3, weapon) { m_name = name; }
+    void get_radar_direction(int& radar_direction) override { radar_direction = 0; }
+    void process_radar_results(const std::vector<RadarObj>&) override {}
+    bool get_shot_location(int&, int&) override { return false; }
+    void get_movement(int& direction, int& distance) override { direction = distance = 0; }
+};
+
+ReplayWriter::ReplayWriter(int fd, int rows, int cols, std::uint32_t seed, const std::vector<RobotBase*>& robots,
+                           const char* cells, int stride, int keyframe_every)
+    : m_out(fd, true, LogSink::every_kb, 256), m_rows(rows), m_cols(cols), m_keyframe_every(std::max(keyframe_every, 1)),
+      m_cells(rows * cols), m_occupants(rows * cols)
+{
+    m_record.append(replay_magic, sizeof(replay_magic));
+    append_u32(m_record, replay_version);
+    append_u32(m_record, rows);
+    append_u32(m_record, cols);
+    append_u32(m_record, seed);
+    append_u32(m_record, m_keyframe_every);
+    append_u32(m_record, static_cast<std::uint32_t>(robots.size()));
+    for (std::size_t slot = 0; slot < robots.size(); ++slot)
+    {
+        m_slots[robots[slot]] = static_cast<int>(slot);
+        append_u8(m_record, robots[slot]->get_weapon());
+        append_u16(m_record, static_cast<std::uint32_t>(robots[slot]->m_name.size()));
+        m_record += robots[slot]->m_name;
+    }
+    for (int row = 0; row < rows; ++row)
+    {
+        m_record.append(cells + row * stride, cols);
+    }
+    emit();
+}
+
+ReplayWriter::~ReplayWriter()
+{
+    if (!m_finished)
+    {
+        finish(static_cast<int>(m_index.size()), {});
+    }
+}
+
+void ReplayWriter::begin_round(int round, const char* cells, const int* occupant, int stride)
+{
+    const bool keyframe = (m_index.size() % m_keyframe_every) == 0;
+    m_index.push_back(m_offset);
+
+    append_u8(m_record, keyframe ? keyframe_record : delta_record);
+    append_u32(m_record, round);
+
+    // count the changes first, the count goes in front of them
+    std::size_t count_at = m_record.size();
+    if (!keyframe)
+    {
+        append_u32(m_record, 0);
+    }
+
+    std::uint32_t changes = 0;
+    for (int row = 0; row < m_rows; ++row)
+    {
+        for (int col = 0; col < m_cols; ++col)
+        {
+            int cell = row * m_cols + col;
+            char ch = cells[row * stride + col];
+            std::uint16_t who = static_cast<std::uint16_t>(occupant[row * stride + col] + 1);
+            if (!keyframe && ch == m_cells[cell] && who == m_occupants[cell])
+            {
+                continue;
+            }
+            m_cells[cell] = ch;
+            m_occupants[cell] = who;
+            if (!keyframe)
+            {
+                append_u32(m_record, cell);
+                append_u8(m_record, static_cast<unsigned char>(ch));
+                append_u16(m_record, who);
+                ++changes;
+            }
+        }
+    }
+
+    if (keyframe)
+    {
+        m_record.append(m_cells.data(), m_cells.size());
+        for (std::uint16_t who : m_occupants)
+        {
+            append_u16(m_record, who);
+        }
+    }
+    else
+    {
+        std::string count;
+        append_u32(count, changes);
+        m_record.replace(count_at, 4, count);
+    }
+}
+
+void ReplayWriter::end_round(const std::vector<TurnEvent>& events)
+{
+    append_events(events);
+    emit();
+}
+
+void ReplayWriter::finish(int rounds, const std::vector<TurnEvent>& final_events)
+{
+    m_finished = true;
+    std::uint64_t end_offset = m_offset;
+    append_u8(m_record, end_record);
+    append_u32(m_record, rounds);
+    append_events(final_events);
+
+    std::uint64_t index_offset = m_offset + m_record.size();
+    for (std::uint64_t offset : m_index)
+    {
+        append_u64(m_record, offset);
+    }
+    append_u64(m_record, index_offset);
+    append_u64(m_record, end_offset);
+    append_u32(m_record, static_cast<std::uint32_t>(m_index.size()));
+    append_u32(m_record, 0);
+    m_record.append(index_magic, sizeof(index_magic));
+    emit();
+    m_out.flush();
+}
+
+void ReplayWriter::append_events(const std::vector<TurnEvent>& events)
+{
+    append_u32(m_record, static_cast<std::uint32_t>(events.size()));
+    for (const TurnEvent& event : events)
+    {
+        auto slot = m_slots.find(event.robot);
+        append_u8(m_record, static_cast<std::uint8_t>(event.type));
+        append_u8(m_record, static_cast<unsigned char>(event.detail));
+        append_u16(m_record, slot == m_slots.end() ? 0 : slot->second + 1);
+        for (std::int16_t value : {event.row, event.col, event.health, event.armor, event.move, event.amount})
+        {
+            append_u16(m_record, static_cast<std::uint16_t>(value));
+        }
+    }
+}
+
+void ReplayWriter::emit()
+{
+    m_out.write(m_record);
+    m_offset += m_record.size();
+    m_record.clear();
+}
+
+Replay::~Replay()
+{
+    if (m_data)
+    {
+        ::munmap(const_cast<unsigned char*>(m_data), m_size);
+    }
+}
+
+// past a record's events, or nullptr if they run past 'end' or name something that isn't
+// in the match
+static const unsigned char* skip_events(const unsigned char* at, const unsigned char* end, std::size_t robots)
+{
+    if (end - at < 4)
+    {
+        return nullptr;
+    }
+    std::uint64_t count = get_u32(at);
+    at += 4;
+    if (static_cast<std::uint64_t>(end - at) / event_bytes < count)
+    {
+        return nullptr;
+    }
+    for (std::uint64_t i = 0; i < count; ++i, at += event_bytes)
+    {
+        std::uint32_t slot = get_u16(at + 2);
+        if (at[0] > static_cast<std::uint8_t>(TurnEventType::death) || slot == 0 || slot > robots)
+        {
+            return nullptr;
+        }
+    }
+    return at;
+}
+
+bool Replay::open(const char* path)
+{
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    bool ok = ::fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) >= sizeof(replay_magic) + 24 + trailer_bytes;
+    if (ok)
+    {
+        m_size = static_cast<std::size_t>(info.st_size);
+        void* mapped = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        m_data = (mapped == MAP_FAILED) ? nullptr : static_cast<const unsigned char*>(mapped);
+    }
+    ::close(fd);
+    if (!m_data || std::memcmp(m_data, replay_magic, sizeof(replay_magic)) != 0 ||
+        get_u32(m_data + 8) != replay_version ||
+        std::memcmp(m_data + m_size - sizeof(index_magic), index_magic, sizeof(index_magic)) != 0)
+    {
+        return false;
+    }
+
+    const unsigned char* trailer = m_data + m_size - trailer_bytes;
+    std::uint32_t rows = get_u32(m_data + 12), cols = get_u32(m_data + 16);
+    std::uint32_t keyframe_every = get_u32(m_data + 24);
+    std::uint32_t robot_count = get_u32(m_data + 28);
+    if (rows == 0 || cols == 0 || std::uint64_t(rows) * cols > m_size || keyframe_every == 0 || robot_count >= 0xFFFF)
+    {
+        return false;
+    }
+    m_rows = static_cast<int>(rows);
+    m_cols = static_cast<int>(cols);
+    m_seed = get_u32(m_data + 20);
+    m_keyframe_every = static_cast<int>(keyframe_every);
+
+    const unsigned char* at = m_data + 32;
+    for (std::uint32_t slot = 0; slot < robot_count; ++slot)
+    {
+        if (trailer - at < 3 || static_cast<std::size_t>(trailer - at - 3) < get_u16(at + 1))
+        {
+            return false;
+        }
+        WeaponType weapon = static_cast<WeaponType>(at[0]);
+        std::size_t length = get_u16(at + 1);
+        m_names.emplace_back(reinterpret_cast<const char*>(at + 3), length);
+        m_robots.push_back(std::make_unique<ReplayRobot>(m_names.back(), weapon));
+        at += 3 + length;
+    }
+
+    m_index_offset = get_u64(trailer);
+    m_end_offset = get_u64(trailer + 8);
+    m_round_count = get_u32(trailer + 16);
+    const std::uint64_t records_at = static_cast<std::uint64_t>(at - m_data) + std::uint64_t(rows) * cols;
+    if (m_round_count > INT32_MAX || m_index_offset > m_size - trailer_bytes
+        || (m_size - trailer_bytes - m_index_offset) / 8 < m_round_count
+        || m_end_offset < records_at || m_end_offset > m_index_offset)
+    {
+        return false;
+    }
+    return check_records(records_at);
+}
+
+// Everything board_at, events_at and write_text are going to look at, looked at once here,
+// so they can index without checking: every record is inside the file, before the index,
+// a keyframe where there should be one and nowhere else, and every cell and robot it
+// names is on the board and in the match.
+bool Replay::check_records(std::uint64_t records_at) const
+{
+    const unsigned char* end = m_data + m_index_offset;
+    const std::uint64_t count = static_cast<std::uint64_t>(m_rows) * m_cols;
+    const std::size_t robots = m_robots.size();
+
+    for (int round = 0; round < rounds(); ++round)
+    {
+        std::uint64_t offset = round_offset(round);
+        if (offset < records_at || offset > m_end_offset || m_end_offset - offset < 5)
+        {
+            return false;
+        }
+        const unsigned char* at = m_data + offset;
+        const std::uint8_t kind = (round % m_keyframe_every == 0) ? keyframe_record : delta_record;
+        if (at[0] != kind)
+        {
+            return false;
+        }
+        at += 5;
+
+        if (kind == keyframe_record)
+        {
+            if (static_cast<std::uint64_t>(end - at) / 3 < count)
+            {
+                return false;
+            }
+            for (std::uint64_t cell = 0; cell < count; ++cell)
+            {
+                if (get_u16(at + count + 2 * cell) > robots)
+                {
+                    return false;
+                }
+            }
+            at += 3 * count;
+        }
+        else
+        {
+            if (end - at < 4)
+            {
+                return false;
+            }
+            std::uint64_t changes = get_u32(at);
+            at += 4;
+            if (static_cast<std::uint64_t>(end - at) / 7 < changes)
+            {
+                return false;
+            }
+            for (std::uint64_t i = 0; i < changes; ++i, at += 7)
+            {
+                if (get_u32(at) >= count || get_u16(at + 5) > robots)
+                {
+                    return false;
+                }
+            }
+        }
+        if (!skip_events(at, end, robots))
+        {
+            return false;
+        }
+    }
+
+    // the end record: kind, rounds played, then the final stats
+    const unsigned char* at = m_data + m_end_offset;
+    return end - at >= 5 && at[0] == end_record && skip_events(at + 5, end, robots);
+}
+
+std::uint64_t Replay::round_offset(int round) const
+{
+    return get_u64(m_data + m_index_offset + 8 * static_cast<std::uint64_t>(round));
+}
+
+bool Replay::board_at(int round, std::vector<char>& cells, std::vector<int>& occupant) const
+{
+    if (round < 0 || round >= rounds())
+    {
+        return false;
+    }
+    const int count = m_rows * m_cols;
+    cells.resize(count);
+    occupant.resize(count);
+
+    // straight to the keyframe, then the deltas after it
+    int keyframe = round - round % m_keyframe_every;
+    for (int r = keyframe; r <= round; ++r)
+    {
+        const unsigned char* at = m_data + round_offset(r);
+        if (at[0] == keyframe_record)
+        {
+            at += 5;
+            std::memcpy(cells.data(), at, count);
+            for (int cell = 0; cell < count; ++cell)
+            {
+                occupant[cell] = static_cast<int>(get_u16(at + count + 2 * cell)) - 1;
+            }
+        }
+        else
+        {
+            std::uint32_t changes = get_u32(at + 5);
+            at += 9;
+            for (std::uint32_t i = 0; i < changes; ++i, at += 7)
+            {
+                std::uint32_t cell = get_u32(at);
+                cells[cell] = static_cast<char>(at[4]);
+                occupant[cell] = static_cast<int>(get_u16(at + 5)) - 1;
+            }
+        }
+    }
+    return true;
+}
+
+bool Replay::events_at(int round, std::vector<TurnEvent>& events) const
+{
+    events.clear();
+    if (round < 0 || round >= rounds())
+    {
+        return false;
+    }
+    const unsigned char* at = m_data + round_offset(round);
+    if (at[0] == keyframe_record)
+        at += 5 + 3 * static_cast<std::size_t>(m_rows * m_cols);
+    else
+        at += 9 + 7 * static_cast<std::size_t>(get_u32(at + 5));
+    read_events(at, events);
+    return true;
+}
+
+bool Replay::final_events(std::vector<TurnEvent>& events) const
+{
+    events.clear();
+    read_events(m_data + m_end_offset + 5, events);
+    return true;
+}
+
+const unsigned char* Replay::read_events(const unsigned char* at, std::vector<TurnEvent>& events) const
+{
+    std::uint32_t count = get_u32(at);
+    at += 4;
+    for (std::uint32_t i = 0; i < count; ++i, at += event_bytes)
+    {
+        TurnEvent event{};
+        event.type = static_cast<TurnEventType>(at[0]);
+        event.detail = static_cast<char>(at[1]);
+        int slot = static_cast<int>(get_u16(at + 2)) - 1;
+        if (slot >= 0)
+        {
+            event.robot = m_robots[slot].get();
+            event.robot_id = robot_symbol(slot);
+        }
+        std::int16_t* fields[] = {&event.row, &event.col, &event.health, &event.armor, &event.move, &event.amount};
+        for (int field = 0; field < 6; ++field)
+        {
+            *fields[field] = static_cast<std::int16_t>(get_u16(at + 4 + 2 * field));
+        }
+        events.push_back(event);
+    }
+    return at;
+}
+
+void Replay::write_text(std::string& text, bool with_boards) const
+{
+    std::vector<char> cells;
+    std::vector<int> occupant;
+    std::vector<TurnEvent> events;
+    BoardRenderer renderer(m_rows, m_cols);
+
+    text += "match seed " + std::to_string(m_seed) + "\n";
+    for (int round = 0; round < rounds(); ++round)
+    {
+        if (with_boards)
+        {
+            // one keyframe, then it's deltas the rest of the way
+            if (round % m_keyframe_every == 0)
+            {
+                board_at(round, cells, occupant);
+            }
+            else
+            {
+                const unsigned char* at = m_data + round_offset(round);
+                std::uint32_t changes = get_u32(at + 5);
+                at += 9;
+                for (std::uint32_t i = 0; i < changes; ++i, at += 7)
+                {
+                    std::uint32_t cell = get_u32(at);
+                    cells[cell] = static_cast<char>(at[4]);
+                    occupant[cell] = static_cast<int>(get_u16(at + 5)) - 1;
+                }
+            }
+            text += renderer.render(round, cells.data(), occupant.data(), m_cols);
+        }
+        events_at(round, events);
+        format_turn_events(events, text);
+    }
+
+    final_events(events);
+    text += "final stats after " + std::to_string(get_u32(m_data + m_end_offset + 1)) + " rounds:\n";
+    format_turn_events(events, text);
+}
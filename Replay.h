@@ -0,0 +1,106 @@
+#ifndef __REPLAY_H__
+#define __REPLAY_H__
+
+#include "TurnEvents.h"
+#include "LogSink.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+// A match written down so it can be looked at again without running the robots.
+// Everything is little endian.
+//
+//   header    "RWREPLAY", u32 version, u32 rows, u32 cols, u32 seed, u32 keyframe_every,
+//             u32 robot count, then per robot: u8 weapon, u16 name length, name,
+//             then the board before the first round (rows * cols cells)
+//   rounds    one record per round:
+//               u8 kind (0 delta, 1 keyframe), u32 round,
+//               keyframe: rows * cols cells, then rows * cols u16 occupants
+//               delta:    u32 count, then count x (u32 cell, u8 cell char, u16 occupant)
+//               u32 event count, then the round's events
+//   end       u8 kind (2), u32 rounds played, u32 event count, the final stats events
+//   index     u64 offset of every round record
+//   trailer   u64 index offset, u64 end offset, u32 round count, u32 0, "RWINDEX1"
+//
+// The board in a round record is how it was at the start of that round (the one the text
+// log prints). Cells are numbered row * cols + col, an occupant is robot index + 1 (0 for
+// nobody), and an event is 16 bytes: u8 type, u8 detail, u16 robot index + 1, then row,
+// col, health, armor, move and amount as i16. Every keyframe_every'th round is a keyframe,
+// so getting to any round means one keyframe and at most keyframe_every - 1 deltas.
+
+class ReplayWriter
+{
+public:
+    // cells is the board before the first round, row r starting at cells[r * stride]
+    ReplayWriter(int fd, int rows, int cols, std::uint32_t seed, const std::vector<RobotBase*>& robots,
+                 const char* cells, int stride, int keyframe_every = 32);
+    ~ReplayWriter();    // writes the end record (if finish() wasn't called), the index and trailer
+
+    // the board at the start of a round, then what happened in it
+    void begin_round(int round, const char* cells, const int* occupant, int stride);
+    void end_round(const std::vector<TurnEvent>& events);
+    void finish(int rounds, const std::vector<TurnEvent>& final_events);
+
+private:
+    LogSink m_out;
+    int m_rows, m_cols, m_keyframe_every;
+    std::uint64_t m_offset = 0;             // bytes handed to m_out so far
+    std::vector<std::uint64_t> m_index;
+    std::vector<char> m_cells;              // the board in the last record, to take deltas from
+    std::vector<std::uint16_t> m_occupants;
+    std::unordered_map<const RobotBase*, int> m_slots;
+    std::string m_record;                   // the record being put together
+    bool m_finished = false;
+
+    void emit();
+    void append_events(const std::vector<TurnEvent>& events);
+};
+
+// A replay file, mapped into memory.
+class Replay
+{
+public:
+    Replay() = default;
+    ~Replay();
+
+    Replay(const Replay&) = delete;
+    Replay& operator=(const Replay&) = delete;
+
+    // false if it isn't a replay, or any part of it is cut off or doesn't make sense
+    bool open(const char* path);
+
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    int rounds() const { return static_cast<int>(m_round_count); }
+    std::uint32_t seed() const { return m_seed; }
+    const std::vector<std::string>& names() const { return m_names; }
+
+    // the board at the start of 'round' - seeks to the keyframe at or before it and plays
+    // the deltas forward. occupant is the robot index in each cell, or -1.
+    bool board_at(int round, std::vector<char>& cells, std::vector<int>& occupant) const;
+
+    // what happened in 'round', or after the last one for the final stats
+    bool events_at(int round, std::vector<TurnEvent>& events) const;
+    bool final_events(std::vector<TurnEvent>& events) const;
+
+    // the text log this replay was recorded from (with -log=turn or board)
+    void write_text(std::string& text, bool with_boards = true) const;
+
+private:
+    const unsigned char* m_data = nullptr;
+    std::size_t m_size = 0;
+    int m_rows = 0, m_cols = 0, m_keyframe_every = 1;
+    std::uint32_t m_seed = 0, m_round_count = 0;
+    std::uint64_t m_index_offset = 0, m_end_offset = 0;
+    std::vector<std::string> m_names;
+    std::vector<std::unique_ptr<RobotBase>> m_robots;   // stand-ins, so events have a robot to name
+
+    std::uint64_t round_offset(int round) const;
+    bool check_records(std::uint64_t records_at) const;
+    const unsigned char* read_events(const unsigned char* at, std::vector<TurnEvent>& events) const;
+};
+
+#endif
@@ -0,0 +1,68 @@
+#include "RobotLibrary.h"
+#include <filesystem>
+#include <cstdlib>
+#include <dlfcn.h> // For dynamic library loading
+
+std::vector<RobotFactory> load_robot_factories(std::ostream& out, std::ostream& err)
+{
+    namespace fs = std::filesystem;
+    std::vector<RobotFactory> factories;
+
+    try 
+    {
+        // Scan the current directory for Robot_<name>.cpp files
+        for (const auto& entry : fs::directory_iterator(".")) 
+        {
+            if (!entry.is_regular_file()) 
+            {
+                continue;
+            }
+            std::string filename = entry.path().filename().string();
+
+            // Check if the file matches the naming pattern Robot_<name>.cpp
+            if (filename.rfind("Robot_", 0) != 0 || filename.size() < 10 || filename.substr(filename.size() - 4) != ".cpp") 
+            {
+                continue;
+            }
+            std::string robot_name = filename.substr(6, filename.size() - 10); // Extract <name>
+            std::string shared_lib = "lib" + robot_name + ".so";
+
+            // Compile the file into a shared library
+            std::string compile_cmd = "g++ -shared -fPIC -o " + shared_lib + " " + filename + " RobotBase.o -I. -std=c++20";
+            out << "Compiling " << filename << " to " << shared_lib << "...\n";
+
+            int compile_result = std::system(compile_cmd.c_str());
+            if (compile_result != 0) 
+            {
+                err << "Failed to compile " << filename << " with command: " << compile_cmd << std::endl;
+                continue;
+            }
+
+            // Load the shared library dynamically
+            void* handle = dlopen(("./" + shared_lib).c_str(), RTLD_LAZY);
+            if (!handle) 
+            {
+                err << "Failed to load " << shared_lib << ": " << dlerror() << std::endl;
+                continue;
+            }
+
+            // Locate the factory function to create the robot
+            using Create = RobotBase* (*)();
+            Create create_robot = (Create)dlsym(handle, "create_robot");
+            if (!create_robot) 
+            {
+                err << "Failed to find create_robot in " << shared_lib << ": " << dlerror() << std::endl;
+                dlclose(handle);
+                continue;
+            }
+
+            factories.push_back({robot_name, create_robot});
+        }
+    } 
+    catch (const fs::filesystem_error& e) 
+    {
+        err << "Filesystem error: " << e.what() << std::endl;
+    }
+
+    return factories;
+}
@@ -0,0 +1,20 @@
+#ifndef __ROBOTLIBRARY_H__
+#define __ROBOTLIBRARY_H__
+
+#include "RobotBase.h"
+#include <string>
+#include <vector>
+#include <ostream>
+
+// A robot that can be made as many times as it's needed - one per match.
+struct RobotFactory {
+    std::string name;               // <name> from Robot_<name>.cpp
+    RobotBase* (*create)();         // a new robot, for the caller to delete
+};
+
+// Compiles every Robot_<name>.cpp in the current directory into lib<name>.so and loads it.
+// What it's doing goes to 'out', what went wrong to 'err'. A robot that doesn't compile or
+// load is left out. The libraries stay loaded until the program ends.
+std::vector<RobotFactory> load_robot_factories(std::ostream& out, std::ostream& err);
+
+#endif
@@ -2,17 +2,229 @@
 #include <string>
 #include <cstdlib>
 #include <ctime>
+#include <limits>
+#include <cstdint>
+#include <chrono>
+#include <memory>
 #include "Arena.h"
+#include "Tournament.h"
+#include "ForkedTournament.h"
+#include "TournamentDaemon.h"
+#include "MatchCache.h"
+#include "TournamentJournal.h"
+#include <csignal>
+
+// "12x40" or "3,4" - two numbers with 'separator' between them
+static bool parse_pair(const std::string& value, char separator, int& first, int& second)
+{
+    std::size_t split = value.find(separator);
+    std::string a = value.substr(0, split), b = split == std::string::npos ? "" : value.substr(split + 1);
+    for (const std::string& number : {a, b})
+    {
+        if (number.empty() || number.size() > 5 || number.find_first_not_of("0123456789") != std::string::npos)
+        {
+            return false;
+        }
+    }
+    first = std::stoi(a);
+    second = std::stoi(b);
+    return true;
+}
+
+// the numbers after "-name=" in 'arg', or -1 if there aren't any (or too many)
+static int parse_count(const std::string& arg, std::size_t at)
+{
+    std::string value = arg.substr(at);
+    if (value.empty() || value.size() > 9 || value.find_first_not_of("0123456789") != std::string::npos)
+        return -1;
+    return std::stoi(value);
+}
+
+// how a -tournament gets played, from the command line
+struct TournamentOptions {
+    int seeds = 0;                      // -tournament=N, 0 for a single match instead
+    bool pairs = false;
+    int threads = 0;
+    int processes = -1;                 // -1: threads, not processes
+    int timeout_ms = 10000;
+    int round_limit = 1000;
+    std::string cache_directory;        // none: no cache
+    std::string journal;                // none: no journal, unless resuming
+    bool resume = false;
+    int checkpoint_every = 0;           // rounds, 0 for no checkpoints
+};
+
+// -tournament=N: every robot plays N matches (or every pair does, with -pairs), all at once,
+// and the standings get printed at the end. With -processes=P they're played in P worker
+// processes, so a robot that crashes or hangs only forfeits its own match. With -cache=DIR
+// only the matches DIR doesn't have a result for are played (see MatchCache.h).
+//
+// With -journal=FILE every finished match goes in FILE as it's played. With -resume a
+// tournament that got cut short carries on from its journal (RobotWarz.journal unless
+// there's a -journal) instead of starting over (see TournamentJournal.h). -checkpoint=N
+// also writes down the arena every N rounds of every match, and a resumed match that gets
+// back to one is checked against it: that's a check the robots play the same way twice,
+// since the matches that weren't finished are played again from the start either way.
+static int run_tournament(const TournamentOptions& options, int rows, int cols, std::uint32_t seed)
+{
+    std::vector<RobotFactory> factories = load_robot_factories(std::cout, std::cerr);
+    if (factories.empty())
+    {
+        std::cerr << "No robots to play with." << std::endl;
+        return 1;
+    }
+
+    int robots = static_cast<int>(factories.size());
+    std::vector<MatchJob> jobs = options.pairs ? Tournament::pairings(robots, rows, cols, seed, options.seeds)
+                                               : Tournament::free_for_all(robots, rows, cols, seed, options.seeds);
+    Tournament tournament(factories, options.threads, options.round_limit);
+    ForkedTournament forked(tournament, options.processes, options.timeout_ms);
+
+    const std::string journal_file = options.journal.empty() ? "RobotWarz.journal" : options.journal;
+    std::unique_ptr<TournamentJournal> journal;
+    if (!options.journal.empty() || options.resume)
+    {
+        journal = std::make_unique<TournamentJournal>(journal_file);
+        const std::uint64_t identity = TournamentJournal::identify(jobs, options.round_limit);
+        if (options.resume ? !journal->resume(identity, jobs.size()) : !journal->start(identity, jobs.size()))
+        {
+            std::cerr << "Couldn't " << (options.resume ? "resume from " : "write ") << journal_file
+                      << (options.resume ? " - is it for this tournament?" : "") << std::endl;
+            return 1;
+        }
+    }
+    if (options.resume)
+        std::cout << "Resuming: " << journal->done().size() << " matches already played, " << journal->in_flight()
+                  << " checkpoints of matches that weren't finished.\n";
+
+    if (options.processes >= 0)
+        std::cout << "Playing " << jobs.size() << " matches in " << forked.workers() << " worker processes, seeds from " << seed << "...\n";
+    else
+        std::cout << "Playing " << jobs.size() << " matches on " << tournament.threads() << " threads, seeds from " << seed << "...\n";
+
+    // 'some' are at 'positions' in jobs, which is how the journal numbers them; 'kept' is
+    // the cache's, numbered like 'some'
+    std::size_t from_journal = 0;
+    auto play = [&](const std::vector<MatchJob>& some, const std::vector<std::size_t>& positions, const Tournament::Finished& kept) {
+        std::vector<MatchResult> results(some.size());
+        std::vector<MatchJob> left;
+        std::vector<std::size_t> left_at, left_slot;
+        for (std::size_t i = 0; i < some.size(); ++i)
+        {
+            if (journal && journal->done().count(positions[i]))
+            {
+                results[i] = journal->done().at(positions[i]);
+                ++from_journal;
+                if (kept)
+                    kept(i, results[i]);
+                continue;
+            }
+            left.push_back(some[i]);
+            left_at.push_back(positions[i]);
+            left_slot.push_back(i);
+        }
+
+        if (journal)
+        {
+            tournament.set_checkpoints(options.checkpoint_every, [&](std::size_t job, int round, const Arena& arena) {
+                journal->reached(left_at[job], round, arena.save_state());
+            });
+        }
+        auto finished = [&](std::size_t job, const MatchResult& result) {
+            if (journal)
+                journal->finished(left_at[job], result);
+            if (kept)
+                kept(left_slot[job], result);
+        };
+        std::vector<MatchResult> played = options.processes >= 0 ? forked.run(left, finished) : tournament.run(left, finished);
+        for (std::size_t i = 0; i < left.size(); ++i)
+        {
+            results[left_slot[i]] = played[i];
+        }
+        return results;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::size_t> everything(jobs.size());
+    for (std::size_t i = 0; i < jobs.size(); ++i)
+    {
+        everything[i] = i;
+    }
+    MatchCache cache(options.cache_directory, factories, options.round_limit);
+    std::vector<MatchResult> results = options.cache_directory.empty() ? play(jobs, everything, nullptr) : cache.run(jobs, play);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::left << std::setw(20) << "robot" << std::right << std::setw(9) << "matches"
+              << std::setw(8) << "wins" << std::setw(8) << "win %" << std::setw(10) << "forfeits" << "\n";
+    for (const Standing& standing : tournament.standings(jobs, results))
+    {
+        double percent = standing.matches ? 100.0 * standing.wins / standing.matches : 0.0;
+        std::cout << std::left << std::setw(20) << standing.name << std::right << std::setw(9) << standing.matches
+                  << std::setw(8) << standing.wins << std::setw(8) << std::fixed << std::setprecision(1) << percent
+                  << std::setw(10) << standing.forfeits << "\n";
+    }
+    std::cout << jobs.size() << " matches in " << std::setprecision(2) << seconds << " s";
+    if (options.processes >= 0)
+        std::cout << " (" << forked.crashes() << " workers crashed or hung, " << forked.respawns() << " restarted)" << std::endl;
+    else
+        std::cout << " (" << tournament.steals() << " handed between threads)" << std::endl;
+    if (!options.cache_directory.empty())
+        std::cout << cache.reused() << " matches reused from " << options.cache_directory << ", " << cache.recomputed() << " recomputed" << std::endl;
+    if (options.resume)
+        std::cout << from_journal << " matches taken from " << journal_file << "; unfinished ones replayed through "
+                  << journal->verified() << " checkpoints that matched and " << journal->diverged() << " that didn't" << std::endl;
+    return 0;
+}
+
+static TournamentDaemon* running_daemon = nullptr;
+
+static void stop_daemon(int)
+{
+    if (running_daemon)
+        running_daemon->stop();
+}
+
+// -daemon=PATH: load the robots once, then play whatever gets asked for on the Unix socket
+// at PATH (see TournamentDaemon.h) until somebody sends shutdown or we get SIGINT or SIGTERM
+static int run_daemon(const std::string& path, int threads, int round_limit)
+{
+    std::vector<RobotFactory> factories = load_robot_factories(std::cout, std::cerr);
+    if (factories.empty())
+    {
+        std::cerr << "No robots to play with." << std::endl;
+        return 1;
+    }
+    TournamentDaemon daemon(factories, threads, round_limit);
+    if (!daemon.listen(path))
+    {
+        std::cerr << "Couldn't listen on " << path << " - is another daemon there already?" << std::endl;
+        return 1;
+    }
+    running_daemon = &daemon;
+    std::signal(SIGINT, stop_daemon);
+    std::signal(SIGTERM, stop_daemon);
+    std::cout << "Listening on " << path << " with " << factories.size() << " robots." << std::endl;
+    daemon.serve();
+    running_daemon = nullptr;
+    std::cout << "Daemon stopped." << std::endl;
+    return 0;
+}
 
 int main(int argc, char* argv[])
 {
     std::string wait;
     bool live = false; // Default value
+    int tick_ms = 1000; // how long a round stays up in live mode
+    int arena_rows = 20, arena_cols = 20;
+    std::uint32_t seed = static_cast<std::uint32_t>(std::time(nullptr));  // a different match every time, unless -seed=
+    LogOptions log_options;
+    TournamentOptions tournament;
+    std::string daemon_path;
 
     // Parse command-line arguments
-    if (argc > 1)
+    for (int i = 1; i < argc; ++i)
     {
-        std::string arg = argv[1];
+        std::string arg = argv[i];
         if (arg.find("-live=") == 0) // Check if the argument starts with "-live="
         {
             std::string value = arg.substr(6); // Extract the value after "-live="
@@ -25,14 +237,232 @@ int main(int argc, char* argv[])
                 std::cerr << "Invalid value for -live. Using default: false." << std::endl;
             }
         }
+        else if (arg.find("-tick=") == 0) // ms a round in live mode, 0 for as fast as it goes
+        {
+            std::string value = arg.substr(6);
+            if (!value.empty() && value.size() < 7 && value.find_first_not_of("0123456789") == std::string::npos)
+                tick_ms = std::stoi(value);
+            else
+                std::cerr << "Invalid value for -tick. Using default: 1000." << std::endl;
+        }
+        else if (arg.find("-seed=") == 0) // play the match with this seed again (the log has it)
+        {
+            std::string value = arg.substr(6);
+            if (!value.empty() && value.size() < 11 && value.find_first_not_of("0123456789") == std::string::npos
+                && std::stoull(value) <= UINT32_MAX)
+                seed = static_cast<std::uint32_t>(std::stoull(value));
+            else
+                std::cerr << "Invalid value for -seed. Using the time." << std::endl;
+        }
+        else if (arg.find("-tournament=") == 0) // play this many seeds without logging, on every core
+        {
+            tournament.seeds = parse_count(arg, 12);
+            if (tournament.seeds <= 0)
+            {
+                std::cerr << "Invalid value for -tournament. Playing one match." << std::endl;
+                tournament.seeds = 0;
+            }
+        }
+        else if (arg == "-pairs") // tournaments play every pair of robots instead of all of them at once
+        {
+            tournament.pairs = true;
+        }
+        else if (arg.find("-daemon=") == 0) // keep the robots loaded and take jobs on this Unix socket
+        {
+            daemon_path = arg.substr(8);
+            if (daemon_path.empty())
+                std::cerr << "Invalid value for -daemon. Playing one match." << std::endl;
+        }
+        else if (arg.find("-cache=") == 0) // tournaments keep match results here and only play the ones that changed
+        {
+            tournament.cache_directory = arg.substr(7);
+            if (tournament.cache_directory.empty())
+                std::cerr << "Invalid value for -cache. Not caching." << std::endl;
+        }
+        else if (arg.find("-journal=") == 0) // tournaments write down their progress here
+        {
+            tournament.journal = arg.substr(9);
+            if (tournament.journal.empty())
+                std::cerr << "Invalid value for -journal. Not journaling." << std::endl;
+        }
+        else if (arg == "-resume" || arg == "--resume") // carry on with the tournament in the journal (RobotWarz.journal)
+        {
+            tournament.resume = true;
+        }
+        else if (arg.find("-checkpoint=") == 0) // rounds between journal checkpoints of a tournament match, 0 for none
+        {
+            tournament.checkpoint_every = parse_count(arg, 12);
+            if (tournament.checkpoint_every < 0)
+            {
+                std::cerr << "Invalid value for -checkpoint. Using default: 0." << std::endl;
+                tournament.checkpoint_every = 0;
+            }
+        }
+        else if (arg.find("-threads=") == 0) // tournament threads, 0 for one per core
+        {
+            tournament.threads = parse_count(arg, 9);
+            if (tournament.threads < 0)
+            {
+                std::cerr << "Invalid value for -threads. Using one per core." << std::endl;
+                tournament.threads = 0;
+            }
+        }
+        else if (arg.find("-processes=") == 0) // tournament worker processes instead of threads, 0 for one per core
+        {
+            tournament.processes = parse_count(arg, 11);
+            if (tournament.processes < 0)
+                std::cerr << "Invalid value for -processes. Using threads." << std::endl;
+        }
+        else if (arg.find("-timeout=") == 0) // ms a match may take in a worker process before it's killed
+        {
+            tournament.timeout_ms = parse_count(arg, 9);
+            if (tournament.timeout_ms <= 0)
+            {
+                std::cerr << "Invalid value for -timeout. Using default: 10000." << std::endl;
+                tournament.timeout_ms = 10000;
+            }
+        }
+        else if (arg.find("-rounds=") == 0) // a tournament match is a draw after this many rounds
+        {
+            tournament.round_limit = parse_count(arg, 8);
+            if (tournament.round_limit <= 0)
+            {
+                std::cerr << "Invalid value for -rounds. Using default: 1000." << std::endl;
+                tournament.round_limit = 1000;
+            }
+        }
+        else if (arg.find("-size=") == 0) // the arena, rows x cols (20x20)
+        {
+            if (!parse_pair(arg.substr(6), 'x', arena_rows, arena_cols) || arena_rows < 1 || arena_cols < 1)
+            {
+                std::cerr << "Invalid value for -size. Using default: 20x20." << std::endl;
+                arena_rows = arena_cols = 20;
+            }
+        }
+        else if (arg.find("-view=") == 0) // only show rows x cols of the board at a time
+        {
+            if (!parse_pair(arg.substr(6), 'x', log_options.view.rows, log_options.view.cols))
+            {
+                std::cerr << "Invalid value for -view. Showing the whole board." << std::endl;
+                log_options.view.rows = log_options.view.cols = 0;
+            }
+        }
+        else if (arg.find("-view_at=") == 0) // the top left corner of the view, row,col
+        {
+            if (!parse_pair(arg.substr(9), ',', log_options.view.top, log_options.view.left))
+            {
+                std::cerr << "Invalid value for -view_at. Using default: 0,0." << std::endl;
+                log_options.view.top = log_options.view.left = 0;
+            }
+        }
+        else if (arg.find("-follow=") == 0) // keep the view on a robot (by number, from 0) or on the fighting
+        {
+            std::string value = arg.substr(8);
+            if (value == "fight")
+                log_options.view.follow_fight = true;
+            else if (!value.empty() && value.size() < 4 && value.find_first_not_of("0123456789") == std::string::npos)
+                log_options.view.follow = std::stoi(value);
+            else
+                std::cerr << "Invalid value for -follow. Not following anything." << std::endl;
+        }
+        else if (arg.find("-minimap=") == 0) // a minimap this many characters wide
+        {
+            std::string value = arg.substr(9);
+            if (!value.empty() && value.size() < 4 && value.find_first_not_of("0123456789") == std::string::npos)
+                log_options.view.minimap = std::stoi(value);
+            else
+                std::cerr << "Invalid value for -minimap. No minimap." << std::endl;
+        }
+        else if (arg.find("-frames=") == 0) // save every Nth round's board as a picture in RobotWarz_frames/
+        {
+            std::string value = arg.substr(8);
+            if (!value.empty() && value.size() < 7 && value.find_first_not_of("0123456789") == std::string::npos)
+                log_options.frames_every = std::stoi(value);
+            else
+                std::cerr << "Invalid value for -frames. Not saving any." << std::endl;
+        }
+        else if (arg.find("-frame_format=") == 0) // ppm or png
+        {
+            std::string value = arg.substr(14);
+            if (value == "png")
+                log_options.frames_png = true;
+            else if (value != "ppm")
+                std::cerr << "Invalid value for -frame_format. Using default: ppm." << std::endl;
+        }
+        else if (arg.find("-spectate=") == 0) // publish every round in shared memory for the spectate tool
+        {
+            std::string value = arg.substr(10);
+            if (value.empty() || value.find('/', 1) != std::string::npos)
+                std::cerr << "Invalid value for -spectate. Nobody can watch." << std::endl;
+            else
+                log_options.spectate = value[0] == '/' ? value : "/" + value;
+        }
+        else if (arg.find("-compress=") == 0) // gzip the log file (read it back with read_log)
+        {
+            std::string value = arg.substr(10);
+            if (value == "true")
+            {
+                log_options.compress = true;
+            }
+            else if (value != "false")
+            {
+                std::cerr << "Invalid value for -compress. Using default: false." << std::endl;
+            }
+        }
+        else if (arg.find("-replay=") == 0) // record RobotWarz.replay too (look at it with replay)
+        {
+            std::string value = arg.substr(8);
+            if (value == "true")
+            {
+                log_options.replay = true;
+            }
+            else if (value != "false")
+            {
+                std::cerr << "Invalid value for -replay. Using default: false." << std::endl;
+            }
+        }
+        else if (arg.find("-boards=") == 0) // print the board every N rounds, or only when it changed
+        {
+            std::string value = arg.substr(8);
+            if (value == "changed")
+                log_options.board_every = 0;
+            else if (!value.empty() && value.size() < 9 && value.find_first_not_of("0123456789") == std::string::npos && std::stoi(value) > 0)
+                log_options.board_every = std::stoi(value);
+            else
+                std::cerr << "Invalid value for -boards. Using default: 1." << std::endl;
+        }
+        else if (arg.find("-log=") == 0) // how much to log: off, summary, turn or board
+        {
+            std::string value = arg.substr(5);
+            if (value == "off")
+                log_options.level = LogLevel::off;
+            else if (value == "summary")
+                log_options.level = LogLevel::summary;
+            else if (value == "turn")
+                log_options.level = LogLevel::turn;
+            else if (value == "board")
+                log_options.level = LogLevel::board;
+            else
+                std::cerr << "Invalid value for -log. Using default: board." << std::endl;
+        }
         else
         {
             std::cerr << "Unknown argument: " << arg << ". Ignoring it." << std::endl;
         }
     }
 
-    std::srand(static_cast<unsigned>(std::time(nullptr)));
-    Arena the_arena(20, 20);
+    if (!daemon_path.empty())
+    {
+        return run_daemon(daemon_path, tournament.threads, tournament.round_limit);
+    }
+    if (tournament.seeds > 0)
+    {
+        return run_tournament(tournament, arena_rows, arena_cols, seed);
+    }
+
+    Arena the_arena(arena_rows, arena_cols, seed);
+    the_arena.set_log_options(log_options);
+    the_arena.set_live_tick(tick_ms);
     the_arena.initialize_board();
     the_arena.load_robots();
     std::cout << "Press enter key to begin.";
@@ -0,0 +1,104 @@
+#include "ScanKernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SCAN_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+static std::uint64_t match_scalar(const char* cells, char value)
+{
+    std::uint64_t bits = 0;
+    for (int i = 0; i < 64; ++i)
+    {
+        if (cells[i] == value)
+        {
+            bits |= std::uint64_t(1) << i;
+        }
+    }
+    return bits;
+}
+
+#ifdef SCAN_KERNELS_X86
+
+// 16 cells per compare
+__attribute__((target("sse2")))
+static std::uint64_t match_sse2(const char* cells, char value)
+{
+    const __m128i wanted = _mm_set1_epi8(value);
+    std::uint64_t bits = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cells + 16 * i));
+        std::uint32_t mask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, wanted)));
+        bits |= std::uint64_t(mask & 0xFFFF) << (16 * i);
+    }
+    return bits;
+}
+
+// 32 cells per compare
+__attribute__((target("avx2")))
+static std::uint64_t match_avx2(const char* cells, char value)
+{
+    const __m256i wanted = _mm256_set1_epi8(value);
+    __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cells));
+    __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cells + 32));
+    std::uint32_t low_mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, wanted)));
+    std::uint32_t high_mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, wanted)));
+    return std::uint64_t(low_mask) | (std::uint64_t(high_mask) << 32);
+}
+
+#endif
+
+bool scan_kernel_supported(ScanKernel kernel)
+{
+    switch (kernel)
+    {
+        case ScanKernel::scalar:
+            return true;
+#ifdef SCAN_KERNELS_X86
+        case ScanKernel::sse2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2");
+        case ScanKernel::avx2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+ScanKernel best_scan_kernel()
+{
+    static const ScanKernel best = scan_kernel_supported(ScanKernel::avx2) ? ScanKernel::avx2
+                                 : scan_kernel_supported(ScanKernel::sse2) ? ScanKernel::sse2
+                                 : ScanKernel::scalar;
+    return best;
+}
+
+const char* scan_kernel_name(ScanKernel kernel)
+{
+    switch (kernel)
+    {
+        case ScanKernel::sse2: return "sse2";
+        case ScanKernel::avx2: return "avx2";
+        default:               return "scalar";
+    }
+}
+
+std::uint64_t match_cells(ScanKernel kernel, const char* cells, char value)
+{
+    switch (kernel)
+    {
+#ifdef SCAN_KERNELS_X86
+        case ScanKernel::sse2: return match_sse2(cells, value);
+        case ScanKernel::avx2: return match_avx2(cells, value);
+#endif
+        default:               return match_scalar(cells, value);
+    }
+}
+
+std::uint64_t match_cells(const char* cells, char value)
+{
+    return match_cells(best_scan_kernel(), cells, value);
+}
@@ -0,0 +1,19 @@
+#ifndef __SCANKERNELS_H__
+#define __SCANKERNELS_H__
+
+#include <cstdint>
+
+// Turning a run of board cells into a bit mask is the one place the board layers touch
+// every cell, so it gets SIMD versions. The best one the CPU supports is picked the first
+// time it's needed. Everything that isn't x86 gets the plain loop.
+enum class ScanKernel { scalar, sse2, avx2 };
+
+// bit i is set where cells[i] == value, for 64 cells
+std::uint64_t match_cells(const char* cells, char value);
+std::uint64_t match_cells(ScanKernel kernel, const char* cells, char value);
+
+ScanKernel best_scan_kernel();
+bool scan_kernel_supported(ScanKernel kernel);
+const char* scan_kernel_name(ScanKernel kernel);
+
+#endif
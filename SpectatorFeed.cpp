@@ -0,0 +1,261 @@
+#include "SpectatorFeed.h"
+#include "TurnEvents.h"
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "the spectator feed needs lock free atomics in shared memory");
+static_assert(sizeof(SpectatorRobot) == 32 && sizeof(SpectatorStats) == 12, "the spectator feed layout changed");
+
+static const char spectator_magic[8] = {'R', 'W', 'S', 'P', 'E', 'C', 'T', '1'};
+
+// the start of each snapshot; the stats and then the cells follow it
+struct SnapshotHead {
+    std::atomic<std::uint64_t> sequence;
+    std::int32_t round;
+    std::int32_t alive;
+};
+
+// Whether the region called 'name' is a game's that's still going: a header from this
+// version, not marked done, written by a process that's still there. A region that can't
+// be read, or is from some other version, doesn't count.
+static bool in_use(const std::string& name)
+{
+    int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    void* memory = MAP_FAILED;
+    if (::fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) >= sizeof(SpectatorHeader))
+    {
+        memory = ::mmap(nullptr, sizeof(SpectatorHeader), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (memory == MAP_FAILED)
+    {
+        return false;
+    }
+    const SpectatorHeader* header = static_cast<const SpectatorHeader*>(memory);
+    const bool live = std::memcmp(header->magic, spectator_magic, sizeof(spectator_magic)) == 0
+                   && header->version == spectator_version && header->done.load(std::memory_order_acquire) == 0
+                   && header->writer != 0 && (::kill(static_cast<pid_t>(header->writer), 0) == 0 || errno == EPERM);
+    ::munmap(memory, sizeof(SpectatorHeader));
+    return live;
+}
+
+static std::size_t round_up(std::size_t bytes)
+{
+    return (bytes + 63) & ~static_cast<std::size_t>(63);
+}
+
+static std::size_t roster_at()
+{
+    return round_up(sizeof(SpectatorHeader));
+}
+
+static std::size_t snapshots_at(std::size_t robots)
+{
+    return round_up(roster_at() + robots * sizeof(SpectatorRobot));
+}
+
+static std::size_t snapshot_bytes(std::size_t rows, std::size_t cols, std::size_t robots)
+{
+    return round_up(sizeof(SnapshotHead) + robots * sizeof(SpectatorStats) + rows * cols);
+}
+
+SpectatorFeed::SpectatorFeed(const std::string& name, int rows, int cols, const std::vector<RobotBase*>& robots)
+    : m_name(name)
+{
+    const std::size_t count = robots.size();
+    const std::size_t each = snapshot_bytes(rows, cols, count);
+    m_bytes = snapshots_at(count) + 2 * each;
+
+    // a region left behind by a match that didn't finish goes, and anyone still looking at
+    // it keeps it; a match that's still going keeps its name
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0 && errno == EEXIST && !in_use(name))
+    {
+        ::shm_unlink(name.c_str());
+        fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    }
+    if (fd < 0)
+    {
+        return;
+    }
+    void* memory = MAP_FAILED;
+    if (::ftruncate(fd, static_cast<off_t>(m_bytes)) == 0)
+    {
+        memory = ::mmap(nullptr, m_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (memory == MAP_FAILED)
+    {
+        ::shm_unlink(name.c_str());
+        return;
+    }
+
+    // the region comes zeroed, so the atomics already read 0 and nothing is published yet
+    char* base = static_cast<char*>(memory);
+    m_header = reinterpret_cast<SpectatorHeader*>(base);
+    m_header->version = spectator_version;
+    m_header->writer = static_cast<std::uint32_t>(::getpid());
+    m_header->rows = static_cast<std::uint32_t>(rows);
+    m_header->cols = static_cast<std::uint32_t>(cols);
+    m_header->robots = static_cast<std::uint32_t>(count);
+    m_header->snapshot_bytes = static_cast<std::uint32_t>(each);
+
+    SpectatorRobot* roster = reinterpret_cast<SpectatorRobot*>(base + roster_at());
+    for (std::size_t slot = 0; slot < count; ++slot)
+    {
+        roster[slot].symbol = robot_symbol(static_cast<int>(slot));
+        roster[slot].weapon = static_cast<char>(robots[slot]->get_weapon());
+        std::strncpy(roster[slot].name, robots[slot]->m_name.c_str(), sizeof(roster[slot].name) - 1);
+    }
+
+    // the magic goes in last, so a viewer that sees it sees the rest too
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(m_header->magic, spectator_magic, sizeof(spectator_magic));
+}
+
+SpectatorFeed::~SpectatorFeed()
+{
+    if (m_header)
+    {
+        m_header->done.store(1, std::memory_order_release);
+        ::munmap(m_header, m_bytes);
+        ::shm_unlink(m_name.c_str());
+    }
+}
+
+void SpectatorFeed::publish(int round, const char* cells, int stride,
+                            const std::vector<int>& row, const std::vector<int>& col, const std::vector<int>& health,
+                            const std::vector<int>& armor, const std::vector<int>& move, const std::vector<std::uint8_t>& alive)
+{
+    if (!m_header)
+    {
+        return;
+    }
+    const std::size_t count = m_header->robots;
+    const int rows = static_cast<int>(m_header->rows), cols = static_cast<int>(m_header->cols);
+
+    // the one the viewers aren't being pointed at
+    const std::uint32_t target = 1 - m_header->newest.load(std::memory_order_relaxed);
+    char* snapshot = reinterpret_cast<char*>(m_header) + snapshots_at(count) + target * m_header->snapshot_bytes;
+    SnapshotHead* head = reinterpret_cast<SnapshotHead*>(snapshot);
+    SpectatorStats* stats = reinterpret_cast<SpectatorStats*>(snapshot + sizeof(SnapshotHead));
+    char* board = snapshot + sizeof(SnapshotHead) + count * sizeof(SpectatorStats);
+
+    const std::uint64_t sequence = head->sequence.load(std::memory_order_relaxed);
+    head->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    int living = 0;
+    for (std::size_t slot = 0; slot < count; ++slot)
+    {
+        stats[slot].row = static_cast<std::int16_t>(row[slot]);
+        stats[slot].col = static_cast<std::int16_t>(col[slot]);
+        stats[slot].health = static_cast<std::int16_t>(health[slot]);
+        stats[slot].armor = static_cast<std::int16_t>(armor[slot]);
+        stats[slot].move = static_cast<std::int16_t>(move[slot]);
+        stats[slot].alive = alive[slot];
+        living += alive[slot] ? 1 : 0;
+    }
+    for (int r = 0; r < rows; ++r)
+    {
+        std::memcpy(board + static_cast<std::size_t>(r) * cols, cells + static_cast<std::size_t>(r) * stride, cols);
+    }
+    head->round = round;
+    head->alive = living;
+
+    head->sequence.store(sequence + 2, std::memory_order_release);
+    m_header->newest.store(target, std::memory_order_release);
+    m_header->rounds.fetch_add(1, std::memory_order_release);
+}
+
+SpectatorView::SpectatorView(const std::string& name)
+{
+    int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+    {
+        return;
+    }
+    struct stat info;
+    void* memory = MAP_FAILED;
+    if (::fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) >= snapshots_at(0))
+    {
+        m_bytes = static_cast<std::size_t>(info.st_size);
+        memory = ::mmap(nullptr, m_bytes, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (memory == MAP_FAILED)
+    {
+        return;
+    }
+
+    const SpectatorHeader* header = static_cast<const SpectatorHeader*>(memory);
+    const bool valid = std::memcmp(header->magic, spectator_magic, sizeof(spectator_magic)) == 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    m_incompatible = valid && header->version != spectator_version;
+    if (!valid || m_incompatible || m_bytes < snapshots_at(header->robots) + 2 * static_cast<std::size_t>(header->snapshot_bytes))
+    {
+        ::munmap(memory, m_bytes);
+        return;
+    }
+    m_header = header;
+
+    const SpectatorRobot* roster = reinterpret_cast<const SpectatorRobot*>(static_cast<const char*>(memory) + roster_at());
+    m_roster.assign(roster, roster + header->robots);
+}
+
+SpectatorView::~SpectatorView()
+{
+    if (m_header)
+    {
+        ::munmap(const_cast<SpectatorHeader*>(m_header), m_bytes);
+    }
+}
+
+bool SpectatorView::read(SpectatorSnapshot& snapshot, int tries) const
+{
+    if (!m_header || m_header->rounds.load(std::memory_order_acquire) == 0)
+    {
+        return false;
+    }
+    const std::size_t count = m_header->robots;
+    const std::size_t cells = static_cast<std::size_t>(m_header->rows) * m_header->cols;
+    snapshot.stats.resize(count);
+    snapshot.cells.resize(cells);
+
+    for (int attempt = 0; attempt < tries; ++attempt)
+    {
+        // 'done' first: if it's set, the newest snapshot after it is the last one
+        const bool done = m_header->done.load(std::memory_order_acquire) != 0;
+        const std::uint32_t which = m_header->newest.load(std::memory_order_acquire);
+        const char* from = reinterpret_cast<const char*>(m_header) + snapshots_at(count) + which * m_header->snapshot_bytes;
+        const SnapshotHead* head = reinterpret_cast<const SnapshotHead*>(from);
+
+        const std::uint64_t before = head->sequence.load(std::memory_order_acquire);
+        if (before & 1)
+        {
+            continue;
+        }
+        snapshot.round = head->round;
+        snapshot.alive = head->alive;
+        std::memcpy(snapshot.stats.data(), from + sizeof(SnapshotHead), count * sizeof(SpectatorStats));
+        std::memcpy(snapshot.cells.data(), from + sizeof(SnapshotHead) + count * sizeof(SpectatorStats), cells);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (head->sequence.load(std::memory_order_relaxed) == before)
+        {
+            snapshot.done = done;
+            return true;
+        }
+    }
+    return false;
+}
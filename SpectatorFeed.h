@@ -0,0 +1,119 @@
+#ifndef __SPECTATORFEED_H__
+#define __SPECTATORFEED_H__
+
+#include "RobotBase.h"
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// The match as it runs, in a POSIX shared memory region other processes can look at
+// (RobotWarz -spectate=NAME, and the spectate tool to watch it).
+//
+//   header    magic, version, the game's pid, rows, cols, robot count, which snapshot is
+//             newest, done flag
+//   roster    per robot: symbol, weapon, name - written once, before the first snapshot
+//   snapshots two of them, each: sequence number, round, robots alive, then per robot
+//             row, col, health, armor, move and alive, then the board (rows * cols cells)
+//
+// The game writes each round into the snapshot that isn't the newest and then flips
+// 'newest' over, so it never waits for anybody. Each snapshot has a seqlock: its sequence
+// number is odd while it's being written and goes up again when it's done. A viewer copies
+// the newest snapshot and keeps the copy if the sequence number was even and the same
+// before and after - it only has to try again if the game got two rounds ahead of it in
+// the middle of the copy. Viewers only read, so any number of them can come and go.
+
+struct SpectatorRobot {
+    char symbol;
+    char weapon;
+    char name[30];
+};
+
+struct SpectatorStats {
+    std::int16_t row, col, health, armor, move;
+    std::uint8_t alive;
+    std::uint8_t unused;
+};
+
+struct SpectatorHeader {
+    char magic[8];                      // "RWSPECT1"
+    std::uint32_t version;              // spectator_version - the layout of everything after it
+    std::uint32_t writer;               // the game's pid, so a new game can tell a live region from a leftover
+    std::uint32_t rows, cols, robots;
+    std::uint32_t snapshot_bytes;       // how far apart the two snapshots are
+    std::atomic<std::uint32_t> newest;  // 0 or 1, the one to read
+    std::atomic<std::uint32_t> done;    // the match is over, the newest snapshot is the last one
+    std::atomic<std::uint64_t> rounds;  // snapshots published so far, 0: nothing to read yet
+};
+
+// one consistent copy of a snapshot, as a viewer sees it
+struct SpectatorSnapshot {
+    int round = 0;
+    int alive = 0;
+    bool done = false;
+    std::vector<SpectatorStats> stats;  // by robot index
+    std::vector<char> cells;            // rows * cols, no padding
+};
+
+// bump it whenever anything in the region moves
+static constexpr std::uint32_t spectator_version = 2;
+
+// the game's end: creates the region and publishes into it
+class SpectatorFeed
+{
+public:
+    // Makes the region called 'name' - something like "/robotwarz". One left behind by a
+    // game that's over, or whose process is gone, gets replaced; one a game is still
+    // publishing into is left alone and ok() is false. ok() also says whether making it
+    // worked; if it's false, publish() does nothing.
+    SpectatorFeed(const std::string& name, int rows, int cols, const std::vector<RobotBase*>& robots);
+    ~SpectatorFeed();   // marks the match as done and removes the name; attached viewers keep their copy
+
+    SpectatorFeed(const SpectatorFeed&) = delete;
+    SpectatorFeed& operator=(const SpectatorFeed&) = delete;
+
+    bool ok() const { return m_header != nullptr; }
+
+    // The board at the start of 'round' - row r starts at cells[r * stride] - and every
+    // robot's stats, by robot index.
+    void publish(int round, const char* cells, int stride,
+                 const std::vector<int>& row, const std::vector<int>& col, const std::vector<int>& health,
+                 const std::vector<int>& armor, const std::vector<int>& move, const std::vector<std::uint8_t>& alive);
+
+private:
+    std::string m_name;
+    SpectatorHeader* m_header = nullptr;
+    std::size_t m_bytes = 0;
+};
+
+// a viewer's end: attaches to a region read only and takes snapshots of it
+class SpectatorView
+{
+public:
+    // ok() is false if there's no match called 'name' running, or it's from a build of
+    // RobotWarz with a different layout (incompatible() says which)
+    explicit SpectatorView(const std::string& name);
+    ~SpectatorView();
+
+    SpectatorView(const SpectatorView&) = delete;
+    SpectatorView& operator=(const SpectatorView&) = delete;
+
+    bool ok() const { return m_header != nullptr; }
+    bool incompatible() const { return m_incompatible; }
+    int rows() const { return m_header->rows; }
+    int cols() const { return m_header->cols; }
+    const std::vector<SpectatorRobot>& roster() const { return m_roster; }
+
+    // Copies the newest round into 'snapshot'. False if nothing has been published yet, or
+    // the game kept overwriting it for every one of 'tries' attempts.
+    bool read(SpectatorSnapshot& snapshot, int tries = 100) const;
+
+private:
+    const SpectatorHeader* m_header = nullptr;
+    std::size_t m_bytes = 0;
+    bool m_incompatible = false;
+    std::vector<SpectatorRobot> m_roster;
+};
+
+#endif
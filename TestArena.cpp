@@ -1,5 +1,30 @@
 #include "TestArena.h"
 #include <iomanip> // For std::setw
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include "ScanKernels.h"
+#include "Tournament.h"
+#include "ForkedTournament.h"
+#include "TournamentDaemon.h"
+#include "MatchCache.h"
+#include "TournamentJournal.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sstream>
+#include <cstring>
+#include <csignal>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <cstdlib>
+#include <thread>
+#include <atomic>
 
 void TestArena::print_test_result(const std::string& test_name, bool condition) {
     const std::string green = "\033[32m";  // ANSI escape code for green
@@ -28,7 +53,7 @@ void TestArena::test_initialize_board()
     // Check that all cells are one of the valid characters
     for (int row = 0; row < 10; ++row) {
         for (int col = 0; col < 10; ++col) {
-            char cell = arena.m_board[row][col];
+            char cell = arena.m_board.get(row, col);
             if (valid_cells.find(cell) == valid_cells.end()) 
             {
                 board_initialized = false;
@@ -164,7 +189,7 @@ for (size_t i = 0; i < obstacle_tests.size(); ++i) {
     jumperBot->move_to(4, 1);
 
     // Add obstacle
-    arena3.m_board[test_case.obstacle_row][test_case.obstacle_col] = test_case.obstacle;
+    arena3.m_board.set(test_case.obstacle_row, test_case.obstacle_col, test_case.obstacle);
 
     // Run the move logic
     std::cout << "trying to move..." << std::endl;
@@ -181,8 +206,8 @@ for (size_t i = 0; i < obstacle_tests.size(); ++i) {
     print_test_result(test_case.description, (result_row == test_case.expected_row && result_col == test_case.expected_col));
 
     // Reset the robot's position and clear the obstacle
-    arena3.m_board[test_case.obstacle_row][test_case.obstacle_col] = '.';
-    arena3.m_board[result_row][result_col] = '.';
+    arena3.m_board.set(test_case.obstacle_row, test_case.obstacle_col, '.');
+    arena3.m_board.set(result_row, result_col, '.');
 
     // Reinitialize the robot if movement is disabled
     if (jumperBot->get_move() == 0) 
@@ -243,19 +268,19 @@ void TestArena::test_handle_collision() {
     TestRobot robot(5, 3, flamethrower, "CollisionBot");
 
     // Test collision with mound
-    arena.m_board[4][4] = 'M';
+    arena.m_board.set(4, 4, 'M');
     robot.move_to(4, 4);
     arena.handle_collision(&robot, 'M', 4, 4);
     print_test_result("Collision with mound", true);
 
     // Test collision with pit
-    arena.m_board[3][3] = 'P';
+    arena.m_board.set(3, 3, 'P');
     robot.move_to(3, 3);
     arena.handle_collision(&robot, 'P', 3, 3);
     print_test_result("Collision with pit", !robot.get_move());
 
     // Test collision with another robot
-    arena.m_board[2][2] = 'R';
+    arena.m_board.set(2, 2, 'R');
     robot.move_to(2, 2);
     arena.handle_collision(&robot, 'R', 2, 2);
     print_test_result("Collision with robot", true);
@@ -317,20 +342,16 @@ void TestArena::test_grenade_damage() {
     ShooterRobot shooter(grenade, "GrenadeShooter");
     int initial_grenades = shooter.get_grenades();
 
-    shooter.move_to(launch_parameters.test_robot_row, launch_parameters.test_robot_col);
     shooter.set_boundaries(20, 20);
-    arena.m_robots.push_back(&shooter);
-    arena.m_board[launch_parameters.test_robot_row][launch_parameters.test_robot_col] = 'R';
+    arena.add_robot(&shooter, launch_parameters.test_robot_row, launch_parameters.test_robot_col);
 
     // Create and place the target robots
     std::vector<TestRobot*> target_robots;
     for (const auto& robot_data : robots) {
         TestRobot* target_robot = new TestRobot(3, 3, hammer, "TargetBot");
-        target_robot->move_to(robot_data.location.first, robot_data.location.second);
         target_robot->set_boundaries(20, 20);
         target_robots.push_back(target_robot);
-        arena.m_robots.push_back(target_robot);
-        arena.m_board[robot_data.location.first][robot_data.location.second] = 'R';
+        arena.add_robot(target_robot, robot_data.location.first, robot_data.location.second);
     }
 
     // Fire the grenade
@@ -401,18 +422,14 @@ void TestArena::test_robot_with_all_weapons()
         shooter.set_boundaries(20, 20);
         target.set_boundaries(20, 20);
 
-        arena.m_robots.clear();
-        arena.m_robots.push_back(&shooter);
-        arena.m_robots.push_back(&target);
+        arena.clear_robots();
 
-        arena.m_board[1][1] = 'R';
-        shooter.move_to(1, 1);
+        arena.add_robot(&shooter, 1, 1);
         std::cout << "\tShooter at (1,1)\n";
 
         int target_row = weapon_tests[weapon].in_range_row;
         int target_col = weapon_tests[weapon].in_range_col;
-        arena.m_board[target_row][target_col] = 'R';
-        target.move_to(target_row, target_col); // Position the target within range based on the weapon
+        arena.add_robot(&target, target_row, target_col); // Position the target within range based on the weapon
         std::cout << "\tTarget Robot at (" << target_row << "," << target_col << ")" << std::endl;
 
 
@@ -454,18 +471,17 @@ void TestArena::test_robot_with_all_weapons()
         Nextshooter.set_boundaries(20, 20);
         Nexttarget.set_boundaries(20, 20);
 
-        arena.m_robots.clear();
-        arena.m_robots.push_back(&Nextshooter);
-        arena.m_robots.push_back(&Nexttarget);
-
-        arena.m_board[2][2] = 'R';
-        Nextshooter.move_to(2, 2);
+        arena.clear_robots();
+        arena.add_robot(&Nextshooter, 2, 2);
+        int start_row, start_col;
+        Nexttarget.get_current_location(start_row, start_col);
+        arena.add_robot(&Nexttarget, start_row, start_col);
         std::cout << "\tShooter at (2,2)\n";
 
         // out of range target
         target_row = 18;
         target_col = 18;
-        arena.m_board[target_row][target_col] = 'R';
+        arena.m_board.set(target_row, target_col, 'R');
         target.move_to(target_row, target_col); // Position the target within range based on the weapon
         std::cout << "\tTarget Robot at (" << target_row << "," << target_col << ")" << std::endl;
 
@@ -550,14 +566,10 @@ void TestArena::test_radar() {
         // Set up the robots
         TestRobot test_robot(3, 3, railgun, "TestRobot");
         TestRobot target_robot(3, 3, hammer, "TargetRobot");
-        test_robot.move_to(test.test_robot_row, test.test_robot_col);
-        target_robot.move_to(test.target_robot_row, test.target_robot_col);
 
         // Place robots in the arena
-        arena.m_robots.push_back(&test_robot);
-        arena.m_robots.push_back(&target_robot);
-        arena.m_board[test.test_robot_row][test.test_robot_col] = 'R';
-        arena.m_board[test.target_robot_row][test.target_robot_col] = 'R';
+        arena.add_robot(&test_robot, test.test_robot_row, test.test_robot_col);
+        arena.add_robot(&target_robot, test.target_robot_row, test.target_robot_col);
 
         // Debugging: Print the board
         arena.print_board(0, std::cout, false);
@@ -629,17 +641,15 @@ void TestArena::test_radar_local() {
 
         // Create the test robot
         TestRobot test_robot(3, 3, railgun, "TestRobot");
-        test_robot.move_to(2, 2); // Place the robot in the center of the arena
         test_robot.set_boundaries(5, 5);
-        arena.m_robots.push_back(&test_robot);
-        arena.m_board[2][2] = 'R'; // Mark the robot's position on the board
+        arena.add_robot(&test_robot, 2, 2); // Place the robot in the center of the arena
 
         // Place objects in the specified positions
         for (const auto& offset : test.object_positions) {
             int obj_row = 2 + offset.first;
             int obj_col = 2 + offset.second;
             if (obj_row >= 0 && obj_row < 5 && obj_col >= 0 && obj_col < 5) {
-                arena.m_board[obj_row][obj_col] = 'M'; // Use 'M' to represent objects
+                arena.m_board.set(obj_row, obj_col, 'M'); // Use 'M' to represent objects
             }
         }
 
@@ -664,4 +674,1622 @@ void TestArena::test_radar_local() {
     }
 
     std::cout << "\t*** Radar local testing complete ***\n\n";
-}
\ No newline at end of file
+}
+// the cell -> robot index has to follow the robots around the board
+void TestArena::test_robot_index() {
+    std::cout << "\n----------------Testing Robot Index----------------\n";
+
+    Arena arena(10, 10);
+    arena.initialize_board(true);
+
+    JumperRobot jumper;             // always moves right 5
+    TestRobot sitter(3, 3, hammer, "SitterBot");
+    jumper.set_boundaries(10, 10);
+    sitter.set_boundaries(10, 10);
+
+    arena.add_robot(&jumper, 2, 1);
+    arena.add_robot(&sitter, 2, 9);
+
+    print_test_result("Robot index finds the first robot", arena.get_robot_index(2, 1) == 0);
+    print_test_result("Robot index finds the second robot", arena.get_robot_index(2, 9) == 1);
+    print_test_result("Robot index is -1 for an empty cell", arena.get_robot_index(5, 5) == -1);
+
+    // moves 5 to the right, (2,6)
+    arena.handle_move(&jumper);
+    print_test_result("Robot index follows a move", arena.get_robot_index(2, 6) == 0);
+    print_test_result("Robot index clears the old cell", arena.get_robot_index(2, 1) == -1);
+
+    // runs into the sitter and stops at (2,8)
+    arena.handle_move(&jumper);
+    print_test_result("Robot index after a collision", arena.get_robot_index(2, 8) == 0 && arena.get_robot_index(2, 9) == 1);
+
+    arena.clear_robots();
+    print_test_result("Robot index is empty after clear_robots", arena.get_robot_index(2, 8) == -1 && arena.get_robot_index(2, 9) == -1);
+
+    std::cout << "\t*** Robot index testing complete ***\n\n";
+}
+
+// railgun hits come back in order along the ray, and the ray stops exactly at the edge
+void TestArena::test_railgun_path() {
+    std::cout << "\n----------------Testing Railgun Path----------------\n";
+
+    Arena arena(20, 20);
+    arena.initialize_board(true);
+
+    ShooterRobot shooter(railgun, "RailBot");
+    TestRobot far_bot(3, 3, hammer, "FarBot");
+    TestRobot near_bot(3, 3, hammer, "NearBot");
+    TestRobot corner_bot(3, 3, hammer, "CornerBot");
+
+    arena.add_robot(&shooter, 5, 5);
+    arena.add_robot(&far_bot, 5, 12);
+    arena.add_robot(&near_bot, 5, 7);
+    arena.add_robot(&corner_bot, 0, 6);
+
+    // straight right - goes past the shot location to the edge, nearest robot first
+    std::vector<int> hits;
+    arena.trace_railgun(5, 5, 5, 9, hits);
+    print_test_result("Railgun hits are in order along the ray",
+        hits.size() == 2 && hits[0] == 2 && hits[1] == 1);
+
+    // 12 steps to go up 1 row. Step 6 is exactly half a row above the board, which
+    // rounds away from zero and leaves the arena, so (0,6) is never reached.
+    arena.trace_railgun(0, 0, -1, 12, hits);
+    print_test_result("Railgun stops exactly half a cell off the edge", hits.empty());
+
+    // from (0,0) to (0,6) hits the corner bot
+    arena.trace_railgun(0, 0, 0, 6, hits);
+    print_test_result("Railgun hits along the top edge", hits.size() == 1 && hits[0] == 3);
+
+    // the full shot leaves the shooter alone
+    int shooter_health = shooter.get_health();
+    arena.handle_railgun_shot(&shooter, 5, 9);
+    print_test_result("Railgun shot damages both robots in line",
+        near_bot.get_health() < 100 && far_bot.get_health() < 100 && shooter.get_health() == shooter_health);
+
+    std::cout << "\t*** Railgun path testing complete ***\n\n";
+}
+
+// This is how handle_flame_shot used to build the flame, one cell at a time. The flame
+// tables have to burn exactly the same cells.
+static std::set<std::pair<int, int>> reference_flame_cells(int size_row, int size_col, int current_row, int current_col,
+                                                           int shot_row, int shot_col)
+{
+    std::set<std::pair<int, int>> flame_cells;
+    int delta_row = shot_row - current_row;
+    int delta_col = shot_col - current_col;
+
+    int steps = 4;
+    double slope_row = static_cast<double>(delta_row) / steps;
+    double slope_col = static_cast<double>(delta_col) / steps;
+    double r = current_row;
+    double c = current_col;
+
+    for (int step = 1; step <= steps; ++step)
+    {
+        r += slope_row;
+        c += slope_col;
+        int path_row = static_cast<int>(std::round(r));
+        int path_col = static_cast<int>(std::round(c));
+
+        if (path_row < 0 || path_row >= size_row || path_col < 0 || path_col >= size_col)
+            break;
+        if (std::sqrt(std::pow(path_row - current_row, 2) + std::pow(path_col - current_col, 2)) > 4.0)
+            break;
+        if (path_row == current_row && path_col == current_col)
+            continue;
+
+        flame_cells.insert({path_row, path_col});
+        for (int offset = -1; offset <= 1; ++offset)
+        {
+            int adj_row = path_row + offset * (delta_col != 0 ? 0 : 1);
+            int adj_col = path_col + offset * (delta_row != 0 ? 0 : 1);
+            if (adj_row >= 0 && adj_row < size_row && adj_col >= 0 && adj_col < size_col &&
+                std::sqrt(std::pow(adj_row - current_row, 2) + std::pow(adj_col - current_col, 2)) <= 4.0)
+                flame_cells.insert({adj_row, adj_col});
+        }
+    }
+    return flame_cells;
+}
+
+// fill the board with robots, fire the flamethrower every which way and check exactly the
+// robots in the old flame got burned
+void TestArena::test_flame_stencil() {
+    std::cout << "\n----------------Testing Flame Stencil----------------\n";
+
+    // the edges are where the rounding gets interesting
+    const int size = 6;
+    const int positions[] = {0, 1, 5};
+    int shots = 0, mismatches = 0;
+
+    for (int current_row : positions) {
+        for (int current_col : positions) {
+            for (int shot_row = current_row - 19; shot_row <= current_row + 19; ++shot_row) {
+                for (int shot_col = current_col - 19; shot_col <= current_col + 19; ++shot_col) {
+                    Arena arena(size, size);
+                    arena.initialize_board(true);
+
+                    ShooterRobot shooter(flamethrower, "FlameBot");
+                    arena.add_robot(&shooter, current_row, current_col);
+
+                    std::vector<std::unique_ptr<TestRobot>> targets;
+                    for (int row = 0; row < size; ++row) {
+                        for (int col = 0; col < size; ++col) {
+                            if (row == current_row && col == current_col)
+                                continue;
+                            targets.push_back(std::make_unique<TestRobot>(3, 3, hammer, "TargetBot"));
+                            arena.add_robot(targets.back().get(), row, col);
+                        }
+                    }
+
+                    arena.handle_flame_shot(&shooter, shot_row, shot_col);
+
+                    auto expected = reference_flame_cells(size, size, current_row, current_col, shot_row, shot_col);
+                    for (auto& target : targets) {
+                        int row, col;
+                        target->get_current_location(row, col);
+                        bool burned = target->get_health() < 100;
+                        if (burned != (expected.count({row, col}) > 0))
+                            ++mismatches;
+                    }
+                    ++shots;
+                }
+            }
+        }
+    }
+
+    std::cout << "\t  " << shots << " shots, " << mismatches << " robots burned differently\n";
+    print_test_result("Flame tables match the flame geometry", mismatches == 0);
+
+    std::cout << "\t*** Flame stencil testing complete ***\n\n";
+}
+
+// the area queries have to find the same robots as looking at every cell
+void TestArena::test_area_queries() {
+    std::cout << "\n----------------Testing Area Queries----------------\n";
+
+    // wider than 64 columns so spans cross more than one word of robot bits
+    const int rows = 12, cols = 70;
+    Arena arena(rows, cols);
+    arena.initialize_board(true);
+
+    std::vector<std::unique_ptr<TestRobot>> robots;
+    for (int row = 0; row < rows; ++row) {
+        for (int col = 0; col < cols; ++col) {
+            if ((row * 7 + col * 13) % 5 == 0) {
+                robots.push_back(std::make_unique<TestRobot>(3, 3, hammer, "AreaBot"));
+                arena.add_robot(robots.back().get(), row, col);
+            }
+        }
+    }
+    // a dead robot doesn't count
+    arena.m_board.set(0, 0, 'X');
+
+    auto brute_force = [&](auto inside) {
+        std::vector<int> found;
+        for (int row = 0; row < rows; ++row)
+            for (int col = 0; col < cols; ++col)
+                if (inside(row, col) && arena.m_board.get(row, col) == 'R')
+                    found.push_back(arena.get_robot_index(row, col));
+        return found;
+    };
+
+    bool rect_ok = true, disc_ok = true, mask_ok = true, cell_ok = true;
+    const int corners[][4] = {{-3, -3, 2, 2}, {0, 0, 11, 69}, {5, 60, 20, 90}, {3, 10, 3, 68}, {-5, -5, -1, -1}};
+    for (const auto& c : corners) {
+        std::vector<int> found;
+        arena.robots_in_rect(c[0], c[1], c[2], c[3], [&](int slot) { found.push_back(slot); });
+        rect_ok = rect_ok && found == brute_force([&](int row, int col) {
+            return row >= c[0] && row <= c[2] && col >= c[1] && col <= c[3];
+        });
+    }
+
+    const int discs[][3] = {{5, 5, 3}, {0, 0, 4}, {11, 69, 2}, {6, 35, 6}, {6, 35, 0}};
+    for (const auto& d : discs) {
+        std::vector<int> found;
+        arena.robots_in_disc(d[0], d[1], d[2], [&](int slot) { found.push_back(slot); });
+        disc_ok = disc_ok && found == brute_force([&](int row, int col) {
+            return (row - d[0]) * (row - d[0]) + (col - d[1]) * (col - d[1]) <= d[2] * d[2];
+        });
+    }
+
+    for (int left = -10; left < cols; left += 7) {
+        std::vector<int> found;
+        const std::uint64_t mask = 0x1F3;
+        arena.robots_in_row_mask(4, left, mask, [&](int slot) { found.push_back(slot); });
+        mask_ok = mask_ok && found == brute_force([&](int row, int col) {
+            return row == 4 && col - left >= 0 && col - left < 64 && ((mask >> (col - left)) & 1);
+        });
+    }
+
+    for (int row = 0; row < rows; ++row) {
+        for (int col = 0; col < cols; ++col) {
+            int expected = (arena.m_board.get(row, col) == 'R') ? arena.get_robot_index(row, col) : -1;
+            cell_ok = cell_ok && arena.robot_at(row, col) == expected;
+        }
+    }
+
+    print_test_result("Rectangle query finds the robots", rect_ok);
+    print_test_result("Disc query finds the robots", disc_ok);
+    print_test_result("Row mask query finds the robots", mask_ok);
+    print_test_result("Single cell query finds the robots", cell_ok);
+
+    std::cout << "\t*** Area query testing complete ***\n\n";
+}
+
+// the bit layers have to agree with the cells, whichever scan kernel built them, and the
+// radar lanes have to see the same things as walking the beam cell by cell
+void TestArena::test_board_layers() {
+    std::cout << "\n----------------Testing Board Layers----------------\n";
+
+    // every kernel this CPU has against the plain loop
+    const char kinds[] = {'.', 'R', 'X', 'M', 'P', 'F', '#'};
+    unsigned seed = 12345;
+    auto next = [&seed]() { seed = seed * 1103515245u + 12345u; return (seed >> 16) & 0x7FFF; };
+
+    bool kernels_ok = true;
+    char cells[64];
+    for (int trial = 0; trial < 200; ++trial) {
+        for (char& cell : cells)
+            cell = kinds[next() % 7];
+        for (ScanKernel kernel : {ScanKernel::sse2, ScanKernel::avx2}) {
+            if (!scan_kernel_supported(kernel))
+                continue;
+            for (char kind : kinds)
+                kernels_ok = kernels_ok && match_cells(kernel, cells, kind) == match_cells(ScanKernel::scalar, cells, kind);
+        }
+    }
+    std::cout << "\t  best scan kernel: " << scan_kernel_name(best_scan_kernel()) << "\n";
+    print_test_result("SIMD scan kernels match the scalar one", kernels_ok);
+
+    // more than 64 rows and columns so beams cross words and take more than one chunk
+    const int size = 70;
+    Arena arena(size, size);
+    arena.initialize_board(true);
+    Board& board = arena.m_board;
+    for (int i = 0; i < 2000; ++i)
+        board.set(next() % size, next() % size, kinds[next() % 6]);
+
+    bool layers_ok = true;
+    for (int row = -1; row <= size; ++row) {
+        for (int col = -1; col <= size; ++col) {
+            char cell = board.get(row, col);
+            int index = board.index(row, col);
+            for (int layer = layer_robot; layer <= layer_flame; ++layer)
+                layers_ok = layers_ok && board.bit(static_cast<BoardLayer>(layer), index) == (Board::layer_of(cell) == layer);
+            bool any = (cell != '.' && cell != Board::wall);
+            layers_ok = layers_ok && board.bit(layer_any, index) == any;
+            for (auto orientation : {Board::by_row, Board::by_col, Board::by_diag, Board::by_anti})
+                layers_ok = layers_ok && (board.any_bits(orientation, board.oriented_index(orientation, row, col), 1) == 1) == any;
+        }
+    }
+    print_test_result("Layers follow the cells after set()", layers_ok);
+
+    // a rebuild from scratch has to land in the same place
+    std::vector<std::uint64_t> before;
+    for (int index = 0; index < board.cell_count(); ++index)
+        before.push_back(board.bits(layer_any, index, 1) | board.bits(layer_robot, index, 1) << 1);
+    board.rebuild_layers();
+    bool rebuild_ok = true;
+    for (int index = 0; index < board.cell_count(); ++index)
+        rebuild_ok = rebuild_ok && before[index] == (board.bits(layer_any, index, 1) | board.bits(layer_robot, index, 1) << 1);
+    print_test_result("Rebuilding the layers changes nothing", rebuild_ok);
+
+    // radar against the beam walked one cell at a time
+    auto reference_beam = [&](int row, int col, int radar_direction) {
+        auto [delta_row, delta_col] = directions[radar_direction];
+        std::vector<std::pair<int, int>> found;
+        for (int step = 1; board.in_bounds(row + step * delta_row, col + step * delta_col); ++step) {
+            std::vector<std::pair<int, int>> step_cells = {{0, 0}, {delta_col, -delta_row}, {-delta_col, delta_row}};
+            if (delta_row != 0 && delta_col != 0) {
+                step_cells.push_back({0, delta_row});
+                step_cells.push_back({delta_col, 0});
+            }
+            for (auto [d_row, d_col] : step_cells) {
+                int scan_row = row + step * delta_row + d_row, scan_col = col + step * delta_col + d_col;
+                char cell = board.get(scan_row, scan_col);
+                if (cell != '.' && cell != Board::wall)
+                    found.push_back({scan_row, scan_col});
+            }
+        }
+        return found;
+    };
+
+    bool radar_ok = true;
+    TestRobot scanner(3, 3, railgun, "Scanner");
+    std::vector<RadarObj> results;
+    const int spots[] = {0, 1, 34, 68, 69};
+    for (int row : spots) {
+        for (int col : spots) {
+            scanner.move_to(row, col);
+            for (int radar_direction = 1; radar_direction <= 8; ++radar_direction) {
+                arena.get_radar_ray(&scanner, radar_direction, results);
+                std::vector<std::pair<int, int>> seen;
+                for (const auto& obj : results) {
+                    seen.push_back({obj.m_row, obj.m_col});
+                    radar_ok = radar_ok && obj.m_type == board.get(obj.m_row, obj.m_col);
+                }
+                radar_ok = radar_ok && seen == reference_beam(row, col, radar_direction);
+            }
+        }
+    }
+    print_test_result("Radar lanes see the same cells in the same order", radar_ok);
+
+    std::cout << "\t*** Board layer testing complete ***\n\n";
+}
+
+// the free run tables against walking each line, and a move that uses them
+void TestArena::test_free_runs() {
+    std::cout << "\n----------------Testing Free Runs----------------\n";
+
+    const int rows = 20, cols = 70;
+    Arena arena(rows, cols);
+    arena.initialize_board(true);
+    Board& board = arena.m_board;
+
+    const char kinds[] = {'.', '.', '.', 'R', 'X', 'M', 'P', 'F'};
+    unsigned seed = 777;
+    auto next = [&seed]() { seed = seed * 1103515245u + 12345u; return (seed >> 16) & 0x7FFF; };
+
+    auto runs_ok = [&]() {
+        for (int row = 0; row < rows; ++row) {
+            for (int col = 0; col < cols; ++col) {
+                for (int direction = 1; direction <= 8; ++direction) {
+                    auto [delta_row, delta_col] = directions[direction];
+                    int run = 0;
+                    while (board.get(row + (run + 1) * delta_row, col + (run + 1) * delta_col) == '.')
+                        ++run;
+                    if (board.free_run(board.index(row, col), direction) != run)
+                        return false;
+                }
+            }
+        }
+        return true;
+    };
+
+    bool empty_ok = runs_ok();
+    bool sets_ok = true;
+    for (int round = 0; round < 20; ++round) {
+        for (int i = 0; i < 100; ++i)
+            board.set(next() % rows, next() % cols, kinds[next() % 8]);
+        sets_ok = sets_ok && runs_ok();
+    }
+    print_test_result("Free runs on an empty board", empty_ok);
+    print_test_result("Free runs follow set()", sets_ok);
+
+    // a robot heading for a mound stops next to it, and knows how far it can get first
+    arena.initialize_board(true);
+    TestRobot mover(5, 3, hammer, "Mover");
+    arena.add_robot(&mover, 10, 10);
+    arena.m_board.set(10, 14, 'M');
+    bool reach_ok = arena.max_reachable(&mover, 3) == 3 && arena.max_reachable(&mover, 7) == 5
+                 && arena.max_reachable(&mover, 0) == 0;
+
+    mover.move_attempt = 3;     // TestRobot moves right, 5 cells
+    arena.handle_move(&mover);
+    int row, col;
+    mover.get_current_location(row, col);
+    const TurnEvent& stop = arena.m_events.back();
+    bool move_ok = row == 10 && col == 13
+                && stop.type == TurnEventType::collision && stop.detail == 'M' && stop.row == 10 && stop.col == 14
+                && arena.m_board.get(10, 13) == 'R' && arena.m_board.get(10, 10) == '.'
+                && arena.get_robot_index(10, 13) == 0;
+
+    print_test_result("Max reachable distance", reach_ok);
+    print_test_result("Move stops at the first thing in the way", move_ok);
+
+    std::cout << "\t*** Free run testing complete ***\n\n";
+}
+
+// Arena's copy of the robot fields has to follow what happens to the robots
+void TestArena::test_robot_table() {
+    std::cout << "\n----------------Testing Robot Table----------------\n";
+
+    Arena arena(10, 10);
+    arena.initialize_board(true);
+    TestRobot hitter(3, 2, hammer, "Hitter");
+    TestRobot target(3, 2, hammer, "Target");
+    TestRobot bystander(3, 2, grenade, "Bystander");
+    arena.add_robot(&hitter, 5, 5);
+    arena.add_robot(&target, 5, 6);
+    arena.add_robot(&bystander, 0, 0);
+
+    auto table_matches = [&]() {
+        for (size_t slot = 0; slot < arena.m_robots.size(); ++slot) {
+            RobotBase* robot = arena.m_robots[slot];
+            int row, col;
+            robot->get_current_location(row, col);
+            if (arena.m_state.row[slot] != row || arena.m_state.col[slot] != col ||
+                arena.m_state.health[slot] != robot->get_health() || arena.m_state.armor[slot] != robot->get_armor() ||
+                arena.m_state.move[slot] != robot->get_move() || arena.m_state.grenades[slot] != robot->get_grenades() ||
+                arena.m_state.weapon[slot] != robot->get_weapon())
+                return false;
+        }
+        return true;
+    };
+    print_test_result("Robot table filled in by add_robot", table_matches() && arena.m_alive == std::vector<int>({0, 1, 2}));
+
+    // hammer the target until it drops
+    for (int swing = 0; swing < 20 && target.get_health() > 0; ++swing)
+        arena.handle_hammer_shot(&hitter, 5, 6);
+    print_test_result("Robot table follows the damage", table_matches() && arena.m_state.health[1] == 0);
+    print_test_result("Two robots alive is no winner", !arena.winner());
+
+    arena.retire_robot(1);
+    print_test_result("Retired robot leaves the alive list", arena.m_alive == std::vector<int>({0, 2}) && !arena.m_state.alive[1]);
+    print_test_result("Retired robot is an X on the board", arena.m_board.get(5, 6) == 'X' && arena.robot_at(5, 6) == -1);
+
+    bystander.take_damage(1000);
+    arena.sync_robot(2);
+    print_test_result("Last robot standing is the winner", arena.winner());
+
+    std::cout << "\t*** Robot table testing complete ***\n\n";
+}
+
+// the handlers only record events - the text log is built from them afterwards
+void TestArena::test_turn_events() {
+    std::cout << "\n----------------Testing Turn Events----------------\n";
+
+    Arena arena(10, 10);
+    arena.initialize_board(true);
+    TestRobot shooter(3, 2, railgun, "Shooter");
+    TestRobot target(3, 2, hammer, "Target");
+    arena.add_robot(&shooter, 5, 2);
+    arena.add_robot(&target, 5, 7);
+
+    arena.handle_shot(&shooter, 5, 9);
+    bool events_ok = arena.m_events.size() == 2
+                  && arena.m_events[0].type == TurnEventType::shot && arena.m_events[0].detail == railgun
+                  && arena.m_events[1].type == TurnEventType::hit && arena.m_events[1].robot == &target
+                  && arena.m_events[1].health == target.get_health();
+    print_test_result("Railgun hit recorded as events", events_ok);
+
+    std::string text;
+    format_turn_events(arena.m_events, text);
+    std::string expected = "Shooting:  shooting railgun... Target takes " + std::to_string(arena.m_events[1].amount)
+                         + " damage. Health: " + std::to_string(target.get_health()) + "\n  ";
+    print_test_result("Railgun hit formats like the old log", text == expected);
+
+    arena.m_events.clear();
+    arena.m_board.set(4, 2, 'P');
+    arena.handle_collision(&shooter, 'P', 4, 2);
+    text.clear();
+    format_turn_events(arena.m_events, text);
+    print_test_result("Pit collision formats like the old log", text == "Shooter is stuck in a pit at (4,2). Movement disabled. \n");
+
+    // there are 39 symbols; robots past them share a fallback instead of reading off the end
+    print_test_result("Robot symbols run out safely", robot_symbol(0) == '!' && robot_symbol(38) == '9'
+                      && robot_symbol(39) == '~' && robot_symbol(1000) == '~' && robot_symbol(-1) == '~');
+
+    std::cout << "\t*** Turn event testing complete ***\n\n";
+}
+
+// whatever goes into a log sink has to come out of it in one piece and in order,
+// even when the ring is much smaller than the text
+void TestArena::test_log_sink() {
+    std::cout << "\n----------------Testing Log Sink----------------\n";
+
+    std::string expected;
+    for (int line = 0; line < 2000; ++line)
+        expected += "line " + std::to_string(line) + " of the log\n";
+
+    auto read_back = [](int fd) {
+        std::string text(static_cast<std::size_t>(::lseek(fd, 0, SEEK_END)), '\0');
+        ::pread(fd, text.data(), text.size(), 0);
+        return text;
+    };
+
+    const LogSink::Flush policies[] = {LogSink::every_round, LogSink::every_kb, LogSink::at_exit};
+    const char* names[] = {"every round", "every kb", "at exit"};
+    for (int i = 0; i < 3; ++i) {
+        char path[] = "/tmp/logsinkXXXXXX";
+        int fd = ::mkstemp(path);
+        bool flushed_ok;
+        {
+            LogSink sink(fd, true, policies[i], 1, 256);
+            for (std::size_t at = 0; at < expected.size(); at += 1000) {
+                sink.write(std::string_view(expected).substr(at, 1000));
+                sink.end_round();
+            }
+            sink.flush();
+            flushed_ok = read_back(fd) == expected;
+            sink.write("after the flush\n");
+        }
+        bool closed_ok = read_back(fd) == expected + "after the flush\n";
+        ::close(fd);
+        ::unlink(path);
+        print_test_result(std::string("Log sink flushing ") + names[i] + " writes everything", flushed_ok && closed_ok);
+    }
+
+    LogSink off(-1, true, LogSink::every_round);
+    off.write("nowhere");
+    off.flush();
+    print_test_result("Log sink without a file is off", !off.enabled());
+
+    std::cout << "\t*** Log sink testing complete ***\n\n";
+}
+
+// summary only writes down the end of the game, off writes nothing at all
+void TestArena::test_log_levels() {
+    std::cout << "\n----------------Testing Log Levels----------------\n";
+
+    auto play = [](LogLevel level, Arena& arena) {
+        LogOptions options;
+        options.level = level;
+        options.console = false;
+        options.file = false;
+        arena.set_log_options(options);
+        arena.run_simulation(false);
+    };
+
+    // a game that is over before it starts
+    TestRobot alive(3, 2, hammer, "Alive");
+    TestRobot dead(3, 2, hammer, "Dead");
+    dead.take_damage(1000);
+
+    Arena summary(10, 10);
+    summary.initialize_board(true);
+    summary.add_robot(&alive, 1, 1);
+    summary.add_robot(&dead, 8, 8);
+    play(LogLevel::summary, summary);
+    bool summary_ok = summary.m_winner == 0 && summary.m_events.size() == 4
+                   && summary.m_events[0].type == TurnEventType::turn && summary.m_events[0].robot == &alive
+                   && summary.m_events[2].type == TurnEventType::turn && summary.m_events[2].health == 0;
+    print_test_result("Summary level records the final stats", summary_ok);
+
+    Arena off(10, 10);
+    off.initialize_board(true);
+    off.add_robot(&alive, 1, 1);
+    off.add_robot(&dead, 8, 8);
+    play(LogLevel::off, off);
+    print_test_result("Off level records nothing", off.m_winner == 0 && off.m_events.empty());
+
+    std::cout << "\t*** Log level testing complete ***\n\n";
+}
+
+// a compressed log has to give back exactly the rounds that went in, picking out a range
+// without needing the rest
+void TestArena::test_compressed_log() {
+    std::cout << "\n----------------Testing Compressed Log----------------\n";
+
+    char path[] = "/tmp/compressedlogXXXXXX";
+    int fd = ::mkstemp(path);
+
+    // rounds of all sorts of sizes, some empty, small blocks so there are plenty of them
+    std::vector<std::string> rounds;
+    for (int round = 0; round < 3000; ++round) {
+        std::string text;
+        for (int line = 0; line < round % 7; ++line)
+            text += "round " + std::to_string(round) + " line " + std::to_string(line) + "\n";
+        rounds.push_back(text);
+    }
+    {
+        CompressedLog log(fd, 4);
+        for (const auto& text : rounds) {
+            log.write(text);
+            log.end_round();
+        }
+    }
+
+    auto read_range = [&](std::uint32_t from, std::uint32_t to, std::vector<std::uint32_t>& seen, bool& text_ok) {
+        return read_compressed_log(fd, from, to, [&](std::uint32_t round, std::string_view text) {
+            seen.push_back(round);
+            text_ok = text_ok && round < rounds.size() && text == rounds[round];
+        });
+    };
+
+    std::vector<std::uint32_t> seen;
+    bool text_ok = true;
+    bool all_ok = read_range(0, UINT32_MAX, seen, text_ok) && text_ok && seen.size() == rounds.size();
+    print_test_result("Compressed log reads back every round", all_ok);
+
+    seen.clear();
+    bool range_ok = read_range(1234, 1240, seen, text_ok) && text_ok
+                 && seen == std::vector<std::uint32_t>({1234, 1235, 1236, 1237, 1238, 1239, 1240});
+    print_test_result("Compressed log reads back a range of rounds", range_ok);
+
+    // a broken file is an error, not a hang or a crash: a member size of 0 (the first
+    // member's is 8 bytes into its RW field), then a byte of the first member's deflate data
+    unsigned char size_bytes[4], zeros[4] = {0, 0, 0, 0};
+    bool broken_ok = ::pread(fd, size_bytes, 4, 16 + 8) == 4 && ::pwrite(fd, zeros, 4, 16 + 8) == 4;
+    broken_ok = broken_ok && !read_range(0, UINT32_MAX, seen, text_ok);
+    broken_ok = broken_ok && ::pwrite(fd, size_bytes, 4, 16 + 8) == 4;
+    const off_t first_size = size_bytes[0] | (size_bytes[1] << 8) | (size_bytes[2] << 16) | (size_bytes[3] << 24);
+    unsigned char byte = 0;
+    broken_ok = broken_ok && ::pread(fd, &byte, 1, first_size - 12) == 1;
+    byte ^= 0x5a;
+    broken_ok = broken_ok && ::pwrite(fd, &byte, 1, first_size - 12) == 1 && !read_range(0, 10, seen, text_ok);
+    print_test_result("Compressed log reader stops at a corrupt member", broken_ok);
+
+    ::close(fd);
+    ::unlink(path);
+
+    std::cout << "\t*** Compressed log testing complete ***\n\n";
+}
+
+// a replay has to give back the board of any round and the text log it was recorded with
+void TestArena::test_replay() {
+    std::cout << "\n----------------Testing Replay----------------\n";
+
+    Arena arena(10, 10);
+    arena.initialize_board(true);
+    TestRobot shooter(3, 2, railgun, "Shooter");
+    TestRobot target(3, 2, hammer, "Target");
+    arena.add_robot(&shooter, 5, 2);
+    arena.add_robot(&target, 5, 7);
+
+    char path[] = "/tmp/replayXXXXXX";
+    int fd = ::mkstemp(path);
+    const int first = arena.m_board.index(0, 0);
+    const int stride = arena.m_board.stride();
+
+    // small keyframe spacing so most rounds come from deltas. A mound shows up every round.
+    std::vector<std::string> boards;
+    std::string expected = "match seed 1234\n";
+    const int rounds = 50;
+    {
+        ReplayWriter writer(fd, 10, 10, 1234, arena.m_robots, arena.m_board.data() + first, stride, 8);
+        for (int round = 0; round < rounds; ++round) {
+            arena.m_events.clear();
+            writer.begin_round(round, arena.m_board.data() + first, arena.m_occupant.data() + first, stride);
+            std::string board;
+            arena.print_board(round, board);
+            boards.push_back(board);
+            expected += board;
+
+            arena.m_board.set(round % 10, (round * 3) % 10, 'M');
+            for (int slot = 0; slot < 2; ++slot) {
+                arena.add_stats_event(slot);
+                if (round % 10 == 3 && slot == 0)
+                    arena.handle_shot(&shooter, 5, 9);
+                arena.add_event(TurnEventType::turn_end, arena.m_robots[slot]);
+            }
+            format_turn_events(arena.m_events, expected);
+            writer.end_round(arena.m_events);
+        }
+        arena.m_events.clear();
+        arena.add_stats_event(1);
+        expected += "final stats after " + std::to_string(rounds) + " rounds:\n";
+        format_turn_events(arena.m_events, expected);
+        writer.finish(rounds, arena.m_events);
+    }
+    ::close(fd);
+
+    Replay replay;
+    bool open_ok = replay.open(path) && replay.rounds() == rounds && replay.seed() == 1234
+                && replay.names() == std::vector<std::string>({"Shooter", "Target"});
+    print_test_result("Replay header reads back", open_ok);
+
+    // out of order, so every one has to find its own keyframe
+    bool boards_ok = open_ok;
+    std::vector<char> cells;
+    std::vector<int> occupant;
+    for (int round : {37, 0, 8, 49, 15, 16, 1}) {
+        std::string text;
+        boards_ok = boards_ok && replay.board_at(round, cells, occupant);
+        format_board(round, 10, 10, cells.data(), occupant.data(), 10, text);
+        boards_ok = boards_ok && text == boards[round];
+    }
+    print_test_result("Replay seeks to any round's board", boards_ok);
+
+    std::string text;
+    if (open_ok)
+        replay.write_text(text);
+    print_test_result("Replay turns back into the text log", text == expected);
+
+    // a damaged file doesn't open, rather than sending the reader off the end of it
+    std::string good;
+    {
+        std::ifstream in(path, std::ios::binary);
+        good.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    auto u64_at = [&](std::size_t at) {
+        std::uint64_t value = 0;
+        for (int byte = 7; byte >= 0; --byte)
+            value = (value << 8) | static_cast<unsigned char>(good[at + byte]);
+        return static_cast<std::size_t>(value);
+    };
+    auto opens_with = [&](std::size_t at, std::initializer_list<unsigned char> bytes) {
+        std::string damaged = good;
+        for (unsigned char byte : bytes)
+            damaged[at++] = static_cast<char>(byte);
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << damaged;
+        Replay broken;
+        return broken.open(path);
+    };
+    const std::size_t index_at = u64_at(good.size() - 32), end_at = u64_at(good.size() - 24);
+    const std::size_t round_one = u64_at(index_at + 8);
+    bool damaged_ok = opens_with(0, {'R'});
+    damaged_ok = damaged_ok && !opens_with(24, {0, 0, 0, 0});                       // keyframe_every 0
+    damaged_ok = damaged_ok && !opens_with(33, {0xff, 0xff});                       // a name past the end
+    damaged_ok = damaged_ok && !opens_with(round_one + 9, {0xff, 0xff, 0, 0});      // a cell off the board
+    damaged_ok = damaged_ok && !opens_with(end_at + 5 + 4 + 2, {9, 0});             // a robot that isn't there
+    damaged_ok = damaged_ok && !opens_with(index_at + 8, {0xff, 0xff, 0xff});       // a round past the index
+    print_test_result("Replay won't open a damaged file", damaged_ok);
+
+    ::unlink(path);
+
+    std::cout << "\t*** Replay testing complete ***\n\n";
+}
+
+// the renderer only rewrites cells, so the title and robots have to come out right
+// whatever was in the frame before
+void TestArena::test_board_renderer() {
+    std::cout << "\n----------------Testing Board Renderer----------------\n";
+
+    const char cells[] = {'.', 'R', 'M', 'X', '.', 'P'};
+    const int occupant[] = {-1, 0, -1, 1, -1, -1};
+    const std::string body = "     0  1  2\n 0   . R!  M\n 1  X@  .  P\n";
+
+    BoardRenderer renderer(2, 3);
+    std::string_view frame = renderer.render(9, cells, occupant, 3);
+    bool first_ok = frame == "\n              =========== starting round 9 ===========\n" + body && renderer.changed();
+    print_test_result("Board renderer formats a frame", first_ok);
+
+    frame = renderer.render(10, cells, occupant, 3);
+    bool again_ok = frame == "\n              =========== starting round 10 ===========\n" + body && !renderer.changed();
+    print_test_result("Board renderer sees an unchanged board", again_ok);
+
+    const char moved[] = {'R', '.', 'M', 'X', '.', 'P'};
+    const int moved_occupant[] = {0, -1, -1, 1, -1, -1};
+    frame = renderer.render(11, moved, moved_occupant, 3);
+    bool moved_ok = renderer.changed() && frame.substr(frame.size() - 26) == " 0  R!  .  M\n 1  X@  .  P\n";
+    print_test_result("Board renderer redraws a robot that moved", moved_ok);
+
+    std::cout << "\t*** Board renderer testing complete ***\n\n";
+}
+
+// after the first frame the live view should only send what changed
+void TestArena::test_live_view() {
+    std::cout << "\n----------------Testing Live View----------------\n";
+
+    LiveView view(2, 3, 0, 0, 0, false);
+    const char cells[] = {'.', 'R', 'M', 'X', '.', 'P'};
+    const int occupant[] = {-1, 0, -1, 1, -1, -1};
+    std::vector<std::string> stats = {"!one", "@two"};
+
+    std::string first;
+    view.draw(0, cells, occupant, 3, 0, 0, stats, first);
+    bool full_ok = first.find("\033[2J") != std::string::npos && first.find(" 0   . R!  M\n") != std::string::npos
+                && first.find("@two") != std::string::npos;
+    print_test_result("Live view draws the whole first frame", full_ok);
+
+    // the robot moves left one cell, and one stats line changes
+    const char moved[] = {'R', '.', 'M', 'X', '.', 'P'};
+    const int moved_occupant[] = {0, -1, -1, 1, -1, -1};
+    stats[0] = "!one moved";
+    std::string update;
+    view.draw(1, moved, moved_occupant, 3, 0, 0, stats, update);
+    bool diff_ok = update.find("\033[2J") == std::string::npos
+                && update.find("\033[4;5HR!") != std::string::npos && update.find("\033[4;8H .") != std::string::npos
+                && update.find("\033[4;11H") == std::string::npos && update.find("\033[5;") == std::string::npos
+                && update.find("!one moved") != std::string::npos && update.find("@two") == std::string::npos;
+    print_test_result("Live view only sends the cells and lines that changed", diff_ok);
+
+    view.handle_key('-');
+    bool keys_ok = view.tick_ms() == 10;
+    view.handle_key('+');
+    view.handle_key('p');
+    keys_ok = keys_ok && view.tick_ms() == 5 && view.paused();
+    view.handle_key(' ');
+    keys_ok = keys_ok && !view.paused();
+    print_test_result("Live view keys change the speed and pause", keys_ok);
+
+    // killed while it's up, it still shows the cursor again on the way out, and still dies
+    // of the signal
+    int pipe_ends[2];
+    bool signal_ok = ::pipe(pipe_ends) == 0;
+    pid_t child = signal_ok ? ::fork() : -1;
+    if (child == 0)
+    {
+        ::dup2(pipe_ends[1], STDOUT_FILENO);
+        LiveView doomed(2, 3, 0, 0, 0, false);
+        std::string frame;
+        doomed.draw(0, cells, occupant, 3, 0, 0, stats, frame);
+        (void)!::write(STDOUT_FILENO, frame.data(), frame.size());
+        ::raise(SIGTERM);
+        ::_exit(0);
+    }
+    ::close(pipe_ends[1]);
+    std::string shown;
+    char buffer[4096];
+    for (ssize_t n; (n = ::read(pipe_ends[0], buffer, sizeof(buffer))) > 0; )
+        shown.append(buffer, static_cast<std::size_t>(n));
+    ::close(pipe_ends[0]);
+    int status = 0;
+    signal_ok = signal_ok && child > 0 && ::waitpid(child, &status, 0) == child
+             && WIFSIGNALED(status) && WTERMSIG(status) == SIGTERM
+             && shown.rfind("\033[?25h") != std::string::npos && shown.rfind("\033[?25h") > shown.find("\033[?25l");
+    print_test_result("Live view puts the cursor back when it's killed", signal_ok);
+
+    std::cout << "\t*** Live view testing complete ***\n\n";
+}
+
+// a window onto a big board: the right cells and numbers, following a robot, and the minimap
+void TestArena::test_viewport() {
+    std::cout << "\n----------------Testing Viewport----------------\n";
+
+    Arena arena(150, 120);
+    arena.initialize_board(true);
+    TestRobot hunter(3, 2, railgun, "Hunter");
+    TestRobot prey(3, 2, hammer, "Prey");
+    arena.add_robot(&hunter, 101, 110);
+    arena.add_robot(&prey, 3, 4);
+    const int first = arena.m_board.index(0, 0);
+    const char* cells = arena.m_board.data() + first;
+    const int* occupant = arena.m_occupant.data() + first;
+    const int stride = arena.m_board.stride();
+
+    // past the bottom right corner, so it has to be pulled back onto the board
+    BoardRenderer renderer(150, 120, 3, 12);
+    std::string_view frame = renderer.render(7, cells, occupant, stride, 100, 115);
+    std::string row_101 = "101 ";
+    for (int col = 108; col < 120; ++col)
+        row_101 += col == 110 ? "  R!" : "   .";
+    bool window_ok = renderer.top() == 100 && renderer.left() == 108
+                  && frame.find("     108 109 110") != std::string_view::npos
+                  && frame.find(row_101 + "\n") != std::string_view::npos;
+    print_test_result("Viewport shows its part of the board", window_ok);
+
+    arena.m_log_options.view.rows = 3;
+    arena.m_log_options.view.cols = 12;
+    arena.m_log_options.view.follow = 1;
+    int top = -1, left = -1;
+    arena.view_origin(renderer, top, left);
+    bool follow_ok = top == 2 && left == 0;
+    print_test_result("Viewport follows a robot", follow_ok);
+
+    // 120 columns in 12 characters is 10 x 20 cells a character
+    Minimap minimap(150, 120, 12, cells, stride);
+    std::string_view map = minimap.render(arena.m_state.row, arena.m_state.col, arena.m_state.alive, 100, 108, 3, 12);
+    bool map_ok = minimap.map_rows() == 8 && map.size() == 8 * 13
+               && map[0] == 'R' && map[5 * 13 + 11] == 'R' && map[5 * 13 + 10] == ' ' && map[13] == '.';
+    print_test_result("Minimap shows the robots and where the viewport is", map_ok);
+
+    std::cout << "\t*** Viewport testing complete ***\n\n";
+}
+
+// pixels in the right colors, files that are real PPM and PNG, and all of them written
+void TestArena::test_frame_export() {
+    std::cout << "\n----------------Testing Frame Export----------------\n";
+
+    const char cells[] = {'.', 'R', 'M', 'X', '.', 'P'};
+    const int occupant[] = {-1, 0, -1, 1, -1, -1};
+
+    std::vector<std::uint8_t> pixels = FrameExporter::rasterize(2, 3, cells, occupant, 3, 2);
+    auto pixel = [&](int y, int x) { return &pixels[3 * (y * 6 + x)]; };
+    bool raster_ok = pixels.size() == 3 * 6 * 4
+                  && std::equal(pixel(0, 2), pixel(0, 2) + 3, pixel(1, 3))     // a square per cell
+                  && !std::equal(pixel(0, 2), pixel(0, 2) + 3, pixel(0, 0))    // robot isn't floor
+                  && !std::equal(pixel(0, 2), pixel(0, 2) + 3, pixel(2, 0))    // two robots, two colors
+                  && std::equal(pixel(0, 0), pixel(0, 0) + 3, pixel(3, 3));    // floor is floor
+    print_test_result("Frame export colors every cell", raster_ok);
+
+    // every robot symbol gets a color nobody else has
+    std::vector<char> roster_cells(39, 'R');
+    std::vector<int> roster_slots(39);
+    for (int slot = 0; slot < 39; ++slot)
+        roster_slots[slot] = slot;
+    std::vector<std::uint8_t> roster_pixels = FrameExporter::rasterize(1, 39, roster_cells.data(), roster_slots.data(), 39, 1);
+    std::set<std::vector<std::uint8_t>> colors;
+    for (int slot = 0; slot < 39; ++slot)
+        colors.insert(std::vector<std::uint8_t>(roster_pixels.begin() + 3 * slot, roster_pixels.begin() + 3 * slot + 3));
+    print_test_result("Frame export has a color for each robot symbol", colors.size() == 39);
+
+    std::string ppm = FrameExporter::encode_ppm(6, 4, pixels);
+    std::string png = FrameExporter::encode_png(6, 4, pixels);
+    bool encode_ok = ppm.compare(0, 11, "P6\n6 4\n255\n") == 0 && ppm.size() == 11 + pixels.size()
+                  && png.compare(0, 8, std::string("\x89PNG\r\n\x1a\n", 8)) == 0
+                  && png.compare(png.size() - 8, 4, "IEND") == 0;
+    print_test_result("Frame export encodes PPM and PNG", encode_ok);
+
+    char directory[] = "/tmp/robotwarz_frames_XXXXXX";
+    bool files_ok = ::mkdtemp(directory) != nullptr;
+    if (files_ok)
+    {
+        {
+            FrameExporter frames(directory, 2, 3, FrameExporter::png, 2, 3);
+            for (int round = 0; round < 20; ++round)
+                frames.add_frame(round, cells, occupant, 3);
+            frames.flush();
+            files_ok = frames.ok();
+        }
+        for (int round = 0; round < 20; ++round)
+        {
+            char name[64];
+            std::snprintf(name, sizeof(name), "%s/frame_%06d.png", directory, round);
+            files_ok = files_ok && ::access(name, R_OK) == 0;
+            ::unlink(name);
+        }
+        ::rmdir(directory);
+    }
+    print_test_result("Frame export writes every frame from its workers", files_ok);
+
+    // somewhere it can't write: it says so before the first frame, and Arena gives up on it
+    Arena arena(2, 3);
+    arena.m_log_options.frames_directory = "/dev/null/frames";
+    arena.m_frames = std::make_unique<FrameExporter>(arena.m_log_options.frames_directory, 2, 3, FrameExporter::ppm, 2, 1);
+    bool failed_ok = !arena.m_frames->ok();
+    arena.check_frames();
+    print_test_result("Frame export that can't write gets turned off", failed_ok && !arena.m_frames);
+
+    std::cout << "\t*** Frame export testing complete ***\n\n";
+}
+
+// a viewer gets what was published, and never half of one round and half of another
+void TestArena::test_spectator_feed() {
+    std::cout << "\n----------------Testing Spectator Feed----------------\n";
+
+    const std::string name = "/robotwarz_test_" + std::to_string(::getpid());
+    TestRobot one(3, 2, railgun, "One");
+    TestRobot two(3, 2, hammer, "Two");
+    std::vector<RobotBase*> robots = {&one, &two};
+    SpectatorFeed feed(name, 4, 5, robots);
+    SpectatorView view(name);
+    SpectatorSnapshot snapshot;
+
+    bool attach_ok = feed.ok() && view.ok() && view.rows() == 4 && view.cols() == 5 && view.roster().size() == 2
+                  && std::string(view.roster()[1].name) == "Two" && view.roster()[1].symbol == robot_symbol(1)
+                  && !view.read(snapshot);
+    print_test_result("Spectator attaches before anything is published", attach_ok);
+
+    // every cell and stat in round n is n, so a torn copy shows up as a mix
+    std::vector<char> cells(4 * 6);
+    std::vector<int> numbers(2);
+    std::vector<std::uint8_t> alive = {1, 0};
+    std::atomic<bool> stop{false};
+    std::thread game([&] {
+        for (int round = 0; !stop; ++round)
+        {
+            std::fill(cells.begin(), cells.end(), static_cast<char>('a' + round % 26));
+            std::fill(numbers.begin(), numbers.end(), round % 1000);
+            feed.publish(round, cells.data(), 6, numbers, numbers, numbers, numbers, numbers, alive);
+        }
+    });
+
+    bool consistent = true;
+    int reads = 0;
+    const auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (reads < 2000 && std::chrono::steady_clock::now() < give_up)
+    {
+        if (!view.read(snapshot))
+            continue;
+        ++reads;
+        const char expect = static_cast<char>('a' + snapshot.round % 26);
+        consistent = consistent && snapshot.alive == 1 && snapshot.stats[1].health == snapshot.round % 1000
+                  && std::all_of(snapshot.cells.begin(), snapshot.cells.end(), [&](char c) { return c == expect; });
+    }
+    stop = true;
+    game.join();
+    print_test_result("Spectator reads whole rounds while the game publishes", consistent && reads > 0);
+
+    // a second game can't take the name while this one is publishing under it
+    {
+        SpectatorFeed second(name, 2, 2, robots);
+        print_test_result("Spectator feed won't take over a live match's region", !second.ok() && SpectatorView(name).rows() == 4);
+    }
+
+    // a viewer won't read a region laid out some other way
+    int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+    void* memory = fd >= 0 ? ::mmap(nullptr, sizeof(SpectatorHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    if (fd >= 0)
+        ::close(fd);
+    bool version_ok = memory != MAP_FAILED;
+    if (version_ok)
+    {
+        SpectatorHeader* header = static_cast<SpectatorHeader*>(memory);
+        header->version = spectator_version + 1;
+        SpectatorView other(name);
+        version_ok = !other.ok() && other.incompatible();
+
+        // nor is another version's region anybody's live match: it gets replaced
+        SpectatorFeed replacement(name, 2, 2, robots);
+        SpectatorView fresh(name);
+        version_ok = version_ok && replacement.ok() && fresh.ok() && fresh.rows() == 2;
+        ::munmap(memory, sizeof(SpectatorHeader));
+    }
+    print_test_result("Spectator checks the region's version", version_ok);
+
+    std::cout << "\t*** Spectator feed testing complete ***\n\n";
+}
+
+// the same seed plays the same game, and one robot's luck doesn't depend on another's
+void TestArena::test_random_streams() {
+    std::cout << "\n----------------Testing Random Streams----------------\n";
+
+    Arena first(30, 30, 99), again(30, 30, 99), other(30, 30, 100);
+    first.initialize_board();
+    again.initialize_board();
+    other.initialize_board();
+    const int cells = first.m_board.cell_count();
+    bool map_ok = std::equal(first.m_board.data(), first.m_board.data() + cells, again.m_board.data())
+               && !std::equal(first.m_board.data(), first.m_board.data() + cells, other.m_board.data());
+    print_test_result("Same seed, same obstacles", map_ok);
+
+    // robot 1's rolls come out the same however many robot 0 has had
+    TestRobot a(3, 2, railgun, "A"), b(3, 2, hammer, "B");
+    TestRobot c(3, 2, railgun, "C"), d(3, 2, hammer, "D");
+    first.add_robot(&a, 1, 1);
+    first.add_robot(&b, 2, 2);
+    again.add_robot(&c, 1, 1);
+    again.add_robot(&d, 2, 2);
+    for (int i = 0; i < 5; ++i)
+        first.damage_random(&a).next();
+    bool streams_ok = true;
+    for (int i = 0; i < 20; ++i)
+        streams_ok = streams_ok && first.calculate_damage(grenade, 0, first.damage_random(&b))
+                                == again.calculate_damage(grenade, 0, again.damage_random(&d));
+    print_test_result("Each robot has its own damage rolls", streams_ok);
+
+    RandomStream stream(7, random_damage);
+    bool range_ok = true;
+    for (int i = 0; i < 10000; ++i)
+    {
+        int value = stream.below(6);
+        range_ok = range_ok && value >= 0 && value < 6;
+    }
+    print_test_result("Random numbers stay in range", range_ok && stream.drawn() == 10000);
+
+    std::cout << "\t*** Random streams testing complete ***\n\n";
+}
+
+// matches on many threads come out the same as on one, and every one gets played
+void TestArena::test_tournament() {
+    std::cout << "\n----------------Testing Tournament----------------\n";
+
+    std::vector<RobotFactory> factories = {
+        {"Rail", []() -> RobotBase* { return new ShooterRobot(railgun, "Rail"); }},
+        {"Grenade", []() -> RobotBase* { return new ShooterRobot(grenade, "Grenade"); }},
+        {"Hammer", []() -> RobotBase* { return new ShooterRobot(hammer, "Hammer"); }},
+        {"Flame", []() -> RobotBase* { return new ShooterRobot(flamethrower, "Flame"); }},
+    };
+    std::vector<MatchJob> jobs = Tournament::pairings(4, 12, 12, 40, 10);
+    std::vector<MatchJob> all = Tournament::free_for_all(4, 12, 12, 40, 10);
+    jobs.insert(jobs.end(), all.begin(), all.end());
+
+    Tournament one(factories, 1, 200), many(factories, 5, 200);
+    std::vector<MatchResult> serial = one.run(jobs);
+    std::vector<MatchResult> parallel = many.run(jobs);
+
+    bool played = serial.size() == jobs.size() && parallel.size() == jobs.size();
+    bool same = played;
+    for (std::size_t i = 0; played && i < jobs.size(); ++i)
+    {
+        played = played && parallel[i].rounds > 0 && parallel[i].health.size() == jobs[i].roster.size();
+        same = same && serial[i].winner == parallel[i].winner && serial[i].rounds == parallel[i].rounds
+            && serial[i].health == parallel[i].health;
+    }
+    print_test_result("Tournament plays every match", played);
+    print_test_result("Tournament results don't depend on the threads", same);
+
+    int wins = 0, matches = 0;
+    for (const Standing& standing : many.standings(jobs, parallel))
+    {
+        wins += standing.wins;
+        matches += standing.matches;
+    }
+    int decided = static_cast<int>(std::count_if(parallel.begin(), parallel.end(), [](const MatchResult& r) { return r.winner >= 0; }));
+    print_test_result("Tournament standings add up", wins == decided && matches == 6 * 10 * 2 + 10 * 4);
+
+    // a library whose factory hands back nothing forfeits its matches instead of crashing them
+    factories.push_back({"Nothing", []() -> RobotBase* { return nullptr; }});
+    Tournament broken(factories, 2, 200);
+    std::vector<MatchJob> with_nothing = Tournament::pairings(5, 12, 12, 40, 1);
+    std::vector<MatchResult> outcome = broken.run(with_nothing);
+    int forfeited = 0;
+    for (std::size_t i = 0; i < with_nothing.size(); ++i)
+    {
+        bool has_nothing = std::find(with_nothing[i].roster.begin(), with_nothing[i].roster.end(), 4) != with_nothing[i].roster.end();
+        forfeited += (has_nothing && outcome[i].forfeit == 4 && outcome[i].winner == -1) ? 1 : 0;
+    }
+    const Standing& last = broken.standings(with_nothing, outcome).back();
+    print_test_result("Tournament forfeits a robot its factory couldn't make", forfeited == 4 && last.name == "Nothing" && last.forfeits == 4);
+
+    std::cout << "\t*** Tournament testing complete ***\n\n";
+}
+
+// a robot that takes its worker down, and one that never gives it back
+class CrashRobot : public ShooterRobot {
+public:
+    CrashRobot() : ShooterRobot(hammer, "Crash") {}
+    void get_radar_direction(int& radar_direction) override {
+        radar_direction = 0;
+        std::raise(SIGSEGV);
+    }
+};
+
+class HangRobot : public ShooterRobot {
+public:
+    HangRobot() : ShooterRobot(hammer, "Hang") {}
+    void get_radar_direction(int& radar_direction) override {
+        radar_direction = 0;
+        while (true)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+};
+
+// crashes and hangs forfeit their own matches, and everything else still gets played
+void TestArena::test_forked_tournament() {
+    std::cout << "\n----------------Testing Forked Tournament----------------\n";
+
+    std::vector<RobotFactory> factories = {
+        {"Rail", []() -> RobotBase* { return new ShooterRobot(railgun, "Rail"); }},
+        {"Grenade", []() -> RobotBase* { return new ShooterRobot(grenade, "Grenade"); }},
+        {"Crash", []() -> RobotBase* { return new CrashRobot(); }},
+        {"Hang", []() -> RobotBase* { return new HangRobot(); }},
+    };
+    std::vector<MatchJob> jobs = Tournament::pairings(4, 12, 12, 70, 2);
+
+    Tournament tournament(factories, 1, 200);
+    ForkedTournament forked(tournament, 2, 200);
+    std::vector<MatchResult> results = forked.run(jobs);
+
+    bool blame_ok = results.size() == jobs.size();
+    bool clean_ok = blame_ok;
+    for (std::size_t i = 0; blame_ok && i < jobs.size(); ++i)
+    {
+        const std::vector<int>& roster = jobs[i].roster;
+        bool has_crash = std::count(roster.begin(), roster.end(), 2) > 0;
+        bool has_hang = std::count(roster.begin(), roster.end(), 3) > 0;
+        int expect = has_crash ? 2 : has_hang ? 3 : -1;     // Crash always goes before Hang
+        blame_ok = blame_ok && results[i].forfeit == expect;
+        if (expect == -1)
+        {
+            MatchResult alone = tournament.play(jobs[i]);
+            clean_ok = clean_ok && results[i].winner == alone.winner && results[i].rounds == alone.rounds
+                    && results[i].health == alone.health;
+        }
+    }
+    print_test_result("Forked tournament blames the robot that crashed or hung", blame_ok);
+    print_test_result("Forked tournament plays the other matches like threads do", clean_ok);
+    print_test_result("Forked tournament restarts its workers", forked.crashes() == 10 && forked.respawns() >= 10 - forked.workers());
+
+    std::vector<Standing> table = tournament.standings(jobs, results);
+    auto forfeits = [&](const std::string& name) {
+        for (const Standing& standing : table)
+            if (standing.name == name)
+                return standing.forfeits;
+        return -1;
+    };
+    print_test_result("Forked tournament counts forfeits", forfeits("Crash") == 6 && forfeits("Hang") == 4 && forfeits("Rail") == 0);
+
+    std::cout << "\t*** Forked tournament testing complete ***\n\n";
+}
+
+void TestArena::test_tournament_daemon() {
+    std::cout << "\n----------------Testing Tournament Daemon----------------\n";
+
+    std::vector<RobotFactory> factories = {
+        {"Rail", []() -> RobotBase* { return new ShooterRobot(railgun, "Rail"); }},
+        {"Grenade", []() -> RobotBase* { return new ShooterRobot(grenade, "Grenade"); }},
+    };
+    std::string path = "/tmp/robotwarz_test_" + std::to_string(::getpid()) + ".sock";
+    TournamentDaemon daemon(factories, 2, 200);
+    bool listening = daemon.listen(path);
+    print_test_result("Daemon listens on its socket", listening);
+    std::thread serving([&]() { daemon.serve(); });
+
+    TournamentDaemon second(factories);
+    print_test_result("Daemon doesn't take over a socket that's answering", !second.listen(path));
+
+    // one client asking everything at once, reading until the daemon hangs up after bye
+    std::string answer;
+    int client = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    if (listening && ::connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0)
+    {
+        std::string requests = "robots\nplay roster=Rail,Grenade size=12x12 seed=70 seeds=3\nplay roster=Nobody\n"
+                               "play roster=all size=2x1\nshutdown\n";
+        ::send(client, requests.data(), requests.size(), MSG_NOSIGNAL);
+        char buffer[1024];
+        ssize_t n;
+        while ((n = ::recv(client, buffer, sizeof(buffer), 0)) > 0)
+        {
+            answer.append(buffer, static_cast<std::size_t>(n));
+        }
+    }
+    ::close(client);
+    daemon.stop();
+    serving.join();
+
+    std::vector<std::string> lines;
+    std::istringstream reading(answer);
+    for (std::string line; std::getline(reading, line);)
+    {
+        lines.push_back(line);
+    }
+    print_test_result("Daemon lists its robots", lines.size() >= 3 && lines[0] == "robot 0 Rail" && lines[1] == "robot 1 Grenade"
+                      && lines[2] == "done 2");
+
+    // the results come in whatever order they finish, so they're matched up by job number
+    Tournament tournament(factories, 1, 200);
+    std::vector<MatchJob> jobs = Tournament::free_for_all(2, 12, 12, 70, 3);
+    int matched = 0;
+    for (std::size_t i = 3; i < lines.size() && i < 6; ++i)
+    {
+        std::istringstream words(lines[i]);
+        std::string result;
+        std::size_t job = 0;
+        words >> result >> job;
+        if (result != "result" || job >= jobs.size())
+        {
+            continue;
+        }
+        MatchResult alone = tournament.play(jobs[job]);
+        std::string expect = "result " + std::to_string(job) + " seed=" + std::to_string(70 + job) + " roster=Rail,Grenade winner="
+                           + (alone.winner >= 0 ? factories[alone.winner].name : std::string("none"))
+                           + " rounds=" + std::to_string(alone.rounds)
+                           + " health=" + std::to_string(alone.health[0]) + "," + std::to_string(alone.health[1]);
+        matched += lines[i] == expect ? 1 : 0;
+    }
+    print_test_result("Daemon plays matches like the tournament does", matched == 3 && lines.size() > 6 && lines[6] == "done 3");
+    print_test_result("Daemon turns down bad requests", lines.size() > 8 && lines[7] == "error unknown robot Nobody"
+                      && lines[8] == "error board too small for the roster");
+    print_test_result("Daemon shuts down when asked", lines.size() == 10 && lines[9] == "bye" && ::access(path.c_str(), F_OK) != 0);
+
+    // a client gone before its matches are: the ones not started are dropped, and there's no done
+    std::size_t replies = 0;
+    bool said_done = false;
+    daemon.answer("play roster=Rail,Grenade size=12x12 seed=1 seeds=200", [&](const std::string& line) {
+        ++replies;
+        said_done = said_done || line.rfind("done", 0) == 0;
+    }, []() { return true; });
+    print_test_result("Daemon drops the matches of a client that hung up", replies < 200 && !said_done);
+
+    // whatever's at the path that isn't a socket stays there
+    {
+        std::ofstream(path) << "not a socket\n";
+    }
+    TournamentDaemon third(factories, 1);
+    print_test_result("Daemon won't replace a file that isn't a socket", !third.listen(path) && ::access(path.c_str(), F_OK) == 0);
+    std::remove(path.c_str());
+
+    std::cout << "\t*** Tournament daemon testing complete ***\n\n";
+}
+
+void TestArena::test_match_cache() {
+    std::cout << "\n----------------Testing Match Cache----------------\n";
+
+    std::vector<RobotFactory> factories = {
+        {"Rail", []() -> RobotBase* { return new ShooterRobot(railgun, "Rail"); }},
+        {"Grenade", []() -> RobotBase* { return new ShooterRobot(grenade, "Grenade"); }},
+        {"Hammer", []() -> RobotBase* { return new ShooterRobot(hammer, "Hammer"); }},
+    };
+    std::vector<MatchJob> jobs = Tournament::pairings(3, 12, 12, 90, 2);
+    Tournament tournament(factories, 2, 200);
+    std::vector<MatchResult> expect = tournament.run(jobs);
+
+    // the robot sources are read from the current directory, so it's a scratch one for this
+    namespace fs = std::filesystem;
+    const fs::path home = fs::current_path();
+    const fs::path scratch = fs::temp_directory_path() / ("robotwarz_cache_" + std::to_string(::getpid()));
+    fs::remove_all(scratch);
+    fs::create_directories(scratch);
+    fs::current_path(scratch);
+    auto write_source = [](const std::string& name, const std::string& text) {
+        std::ofstream(std::string("Robot_") + name + ".cpp") << text;
+    };
+    write_source("Rail", "rail 1");
+    write_source("Grenade", "grenade 1");
+    write_source("Hammer", "hammer 1");
+
+    std::size_t played = 0;
+    auto play = [&](const std::vector<MatchJob>& some, const std::vector<std::size_t>&, const Tournament::Finished& finished) {
+        played += some.size();
+        return tournament.run(some, finished);
+    };
+    auto same = [&](const std::vector<MatchResult>& results) {
+        bool ok = results.size() == expect.size();
+        for (std::size_t i = 0; ok && i < results.size(); ++i)
+            ok = results[i].winner == expect[i].winner && results[i].rounds == expect[i].rounds && results[i].health == expect[i].health;
+        return ok;
+    };
+
+    MatchCache first("cache", factories, 200);
+    bool first_ok = same(first.run(jobs, play)) && first.reused() == 0 && first.recomputed() == jobs.size() && played == jobs.size();
+    print_test_result("Match cache plays what it hasn't seen", first_ok);
+
+    played = 0;
+    MatchCache again("cache", factories, 200);
+    bool again_ok = same(again.run(jobs, play)) && again.reused() == jobs.size() && again.recomputed() == 0 && played == 0;
+    print_test_result("Match cache hands back what it has", again_ok);
+
+    MatchJob swapped = jobs[0], resized = jobs[0], reseeded = jobs[0];
+    std::swap(swapped.roster[0], swapped.roster[1]);
+    resized.cols = 13;
+    reseeded.seed += 1000;
+    const std::string key = again.key(jobs[0]);
+    print_test_result("Match cache keys change with the match", key.size() == 16 && key == first.key(jobs[0]) && key != again.key(swapped)
+                      && key != again.key(resized) && key != again.key(reseeded));
+
+    // editing one robot only loses its own matches: with 3 robots and 2 seeds, 4 of 6
+    write_source("Hammer", "hammer 2");
+    MatchCache edited("cache", factories, 200);
+    bool edited_ok = same(edited.run(jobs, play)) && edited.recomputed() == 4 && edited.reused() == 2;
+    print_test_result("Match cache replays the matches of a robot that changed", edited_ok);
+
+    MatchCache longer("cache", factories, 300);
+    longer.run(jobs, [&](const std::vector<MatchJob>& some, const std::vector<std::size_t>&, const Tournament::Finished&) {
+        return std::vector<MatchResult>(some.size());
+    });
+    print_test_result("Match cache keeps round limits apart", longer.recomputed() == jobs.size());
+
+    // a result whose inputs aren't the match's is somebody else's with the same key
+    const std::string stored = "cache/" + key.substr(0, 2) + "/" + key.substr(2);
+    std::string contents;
+    {
+        std::ifstream in(stored);
+        std::getline(in, contents, '\0');
+    }
+    {
+        std::ofstream(stored) << "inputs somebody else's match\n" << contents.substr(contents.find('\n') + 1);
+    }
+    MatchJob alone = jobs[0];
+    MatchCache colliding("cache", factories, 200);
+    colliding.run({alone}, play);
+    print_test_result("Match cache checks the inputs of what it finds", colliding.recomputed() == 1);
+
+    // each result is kept as soon as it's over, whatever happens to the rest of the run
+    fs::remove_all("cache");
+    MatchCache cut_short("cache", factories, 200);
+    cut_short.run(jobs, [&](const std::vector<MatchJob>& some, const std::vector<std::size_t>&, const Tournament::Finished& finished) {
+        finished(0, tournament.play(some[0]));
+        return std::vector<MatchResult>();
+    });
+    MatchCache after("cache", factories, 200);
+    after.run(jobs, play);
+    print_test_result("Match cache keeps results as they finish", after.reused() == 1 && after.recomputed() == jobs.size() - 1);
+
+    fs::current_path(home);
+    fs::remove_all(scratch);
+
+    std::cout << "\t*** Match cache testing complete ***\n\n";
+}
+
+void TestArena::test_tournament_journal() {
+    std::cout << "\n----------------Testing Tournament Journal----------------\n";
+
+    std::vector<RobotFactory> factories = {
+        {"Rail", []() -> RobotBase* { return new ShooterRobot(railgun, "Rail"); }},
+        {"Grenade", []() -> RobotBase* { return new ShooterRobot(grenade, "Grenade"); }},
+        {"Hammer", []() -> RobotBase* { return new ShooterRobot(hammer, "Hammer"); }},
+    };
+    std::vector<MatchJob> jobs = Tournament::pairings(3, 12, 12, 90, 3);
+    const std::uint64_t identity = TournamentJournal::identify(jobs, 200);
+    const std::string file = "/tmp/robotwarz_journal_" + std::to_string(::getpid());
+
+    // the same arena state for the same match, a different one for another seed
+    auto final_state = [&](const MatchJob& job) {
+        Arena arena(job.rows, job.cols, job.seed);
+        arena.m_log_options.level = LogLevel::off;
+        arena.m_log_options.console = arena.m_log_options.file = false;
+        arena.set_round_limit(200);
+        arena.initialize_board();
+        std::vector<std::unique_ptr<RobotBase>> robots;
+        for (int who : job.roster)
+        {
+            robots.emplace_back(factories[who].create());
+            int row, col;
+            arena.place_robot(robots.back().get(), factories[who].name, row, col);
+        }
+        arena.run_simulation();
+        return arena.save_state();
+    };
+    MatchJob other = jobs[0];
+    other.seed += 1000;
+    print_test_result("Arena state is the same for the same match", final_state(jobs[0]) == final_state(jobs[0])
+                      && final_state(jobs[0]) != final_state(other));
+
+    // the whole tournament, with a checkpoint every 5 rounds
+    Tournament tournament(factories, 2, 200);
+    std::vector<MatchResult> expect;
+    {
+        TournamentJournal journal(file, 10);
+        journal.start(identity, jobs.size());
+        tournament.set_checkpoints(5, [&](std::size_t job, int round, const Arena& arena) { journal.reached(job, round, arena.save_state()); });
+        expect = tournament.run(jobs, [&](std::size_t job, const MatchResult& result) { journal.finished(job, result); });
+    }
+
+    // the crash: only the first three matches got written down as done, and the last line
+    // was cut off half way through
+    std::vector<std::string> lines;
+    {
+        std::ifstream in(file);
+        for (std::string line; std::getline(in, line);)
+            lines.push_back(line);
+    }
+    std::set<std::size_t> kept;
+    std::size_t checkpointed = jobs.size();
+    {
+        std::ofstream out(file, std::ios::trunc);
+        for (const std::string& line : lines)
+        {
+            std::istringstream words(line);
+            std::string tag;
+            std::size_t job = 0;
+            words >> tag >> job;
+            if (tag == "done" && job >= 3)
+                continue;
+            if (tag == "done")
+                kept.insert(job);
+            if (tag == "checkpoint" && job >= 3)
+                checkpointed = job;
+            out << line << "\n";
+        }
+        out << "done 4 1 12";
+    }
+
+    std::vector<MatchResult> resumed(jobs.size());
+    std::size_t replayed = 0;
+    bool resume_ok = false, diverged_ok = false;
+    {
+        TournamentJournal journal(file, 10);
+        resume_ok = journal.resume(identity, jobs.size()) && journal.done().size() == kept.size() && kept.size() == 3
+                    && journal.in_flight() > 0;
+        std::vector<MatchJob> left;
+        std::vector<std::size_t> left_at;
+        for (std::size_t job = 0; job < jobs.size(); ++job)
+        {
+            auto done = journal.done().find(job);
+            if (done != journal.done().end())
+            {
+                resumed[job] = done->second;
+                continue;
+            }
+            left.push_back(jobs[job]);
+            left_at.push_back(job);
+        }
+        replayed = left.size();
+        tournament.set_checkpoints(5, [&](std::size_t job, int round, const Arena& arena) { journal.reached(left_at[job], round, arena.save_state()); });
+        std::vector<MatchResult> played = tournament.run(left, [&](std::size_t job, const MatchResult& result) { journal.finished(left_at[job], result); });
+        for (std::size_t i = 0; i < left.size(); ++i)
+            resumed[left_at[i]] = played[i];
+        resume_ok = resume_ok && journal.verified() > 0 && journal.diverged() == 0;
+
+        if (checkpointed < jobs.size())
+        {
+            journal.reached(checkpointed, 5, "not what it was");
+            diverged_ok = journal.diverged() == 1;
+        }
+    }
+    print_test_result("Journal resumes where the tournament stopped", resume_ok && replayed == jobs.size() - 3);
+    print_test_result("Journal notices a match that didn't play out the same", diverged_ok);
+
+    bool same = true;
+    for (std::size_t job = 0; job < jobs.size(); ++job)
+        same = same && resumed[job].winner == expect[job].winner && resumed[job].rounds == expect[job].rounds
+                    && resumed[job].health == expect[job].health;
+    print_test_result("Journal resume gets the same results", same);
+
+    // the cut off line is gone, and everything is there now
+    TournamentJournal again(file);
+    bool complete = again.resume(identity, jobs.size()) && again.done().size() == jobs.size() && again.in_flight() == 0;
+    TournamentJournal wrong(file);
+    print_test_result("Journal has every match after the resume", complete);
+    print_test_result("Journal won't resume some other tournament", !wrong.resume(identity + 1, jobs.size()));
+
+    // a crash before even the header was all written: there's nothing to carry on from
+    {
+        std::ofstream(file, std::ios::trunc) << "journal 12ab";
+    }
+    TournamentJournal torn(file, 10);
+    bool fresh = torn.resume(identity, jobs.size()) && torn.done().empty();
+    print_test_result("Journal starts over when its header was cut off", fresh);
+
+    // a forked worker only writes to the descriptor, with the syncer thread left behind
+    pid_t child = ::fork();
+    if (child == 0)
+    {
+        torn.finished(0, expect[0]);
+        ::_exit(0);
+    }
+    int status = -1;
+    ::waitpid(child, &status, 0);
+    TournamentJournal after_fork(file);
+    print_test_result("Journal takes results from forked workers", WIFEXITED(status) && WEXITSTATUS(status) == 0
+                      && after_fork.resume(identity, jobs.size()) && after_fork.done().size() == 1);
+
+    std::remove(file.c_str());
+    std::cout << "\t*** Tournament journal testing complete ***\n\n";
+}
+
+void TestArena::test_out_of_range_shot() {
+    std::cout << "\n----------------Testing shots at a robot out of range----------------\n";
+
+    // the target is in the occupancy grid this time, so only the range keeps it safe
+    WeaponType weapons[] = {flamethrower, grenade, hammer};
+    for (WeaponType weapon : weapons)
+    {
+        Arena arena(20, 20);
+        arena.initialize_board(true);
+
+        ShooterRobot shooter(weapon, "ShooterBot");
+        TestRobot target(5, 3, hammer, "TargetBot");
+        shooter.set_boundaries(20, 20);
+        target.set_boundaries(20, 20);
+        arena.add_robot(&shooter, 2, 2);
+        arena.add_robot(&target, 18, 18);
+
+        std::vector<RadarObj> radar_results;
+        radar_results.emplace_back('R', 18, 18);
+        shooter.process_radar_results(radar_results);
+
+        int shot_row = 0, shot_col = 0;
+        shooter.get_shot_location(shot_row, shot_col);
+        int health_before = target.get_health();
+        arena.handle_shot(&shooter, shot_row, shot_col);
+        print_test_result("\t" + std::string(weapon == flamethrower ? "flamethrower" : weapon == grenade ? "grenade" : "hammer")
+                          + " doesn't reach a robot at (18,18)", target.get_health() == health_before);
+    }
+
+    std::cout << "\t*** Out of range shot testing complete ***\n\n";
+}
+
+void TestArena::test_radar_footprints() {
+    std::cout << "\n----------------Testing Radar Beam Footprints----------------\n";
+
+    // A board with something on every cell, so every cell of a beam comes back. Each
+    // direction, from every cell, has to give the cells the old step-by-step scan did:
+    // the middle of the beam, the cells either side and on diagonals the holes, nearest
+    // first, each cell once.
+    const int rows = 9, cols = 13;
+    const std::set<int> diagonal_directions = {2, 4, 6, 8};
+    Arena arena(rows, cols);
+    arena.initialize_board(true);
+    for (int row = 0; row < rows; ++row)
+        for (int col = 0; col < cols; ++col)
+            arena.m_board.set(row, col, 'M');
+
+    TestRobot scanner(3, 3, railgun, "Scanner");
+    scanner.set_boundaries(rows, cols);
+
+    int wrong = 0;
+    for (int radar_direction = 1; radar_direction <= 8; ++radar_direction)
+    {
+        const auto [delta_row, delta_col] = directions[radar_direction];
+        for (int row = 0; row < rows; ++row)
+        {
+            for (int col = 0; col < cols; ++col)
+            {
+                std::vector<std::pair<int, int>> expected;
+                std::set<std::pair<int, int>> seen;
+                auto look = [&](int r, int c) {
+                    if (r >= 0 && r < rows && c >= 0 && c < cols && !(r == row && c == col) && seen.insert({r, c}).second)
+                        expected.emplace_back(r, c);
+                };
+                for (int r = row + delta_row, c = col + delta_col; r >= 0 && r < rows && c >= 0 && c < cols; r += delta_row, c += delta_col)
+                {
+                    look(r, c);
+                    look(r + delta_col, c - delta_row);
+                    look(r - delta_col, c + delta_row);
+                    if (diagonal_directions.count(radar_direction))
+                    {
+                        look(r, c + delta_row);
+                        look(r + delta_col, c);
+                    }
+                }
+
+                scanner.move_to(row, col);
+                std::vector<RadarObj> radar_results;
+                arena.get_radar_results(&scanner, radar_direction, radar_results);
+                std::vector<std::pair<int, int>> found;
+                for (const RadarObj& obj : radar_results)
+                    found.emplace_back(obj.m_row, obj.m_col);
+                if (found != expected)
+                    ++wrong;
+            }
+        }
+    }
+    print_test_result("Every beam, from every cell, covers the cells the step-by-step scan did", wrong == 0);
+
+    // the beam stops at the edge: one step from the right hand wall, looking right, sees
+    // the next column and nothing more
+    std::vector<RadarObj> radar_results;
+    scanner.move_to(4, cols - 2);
+    arena.get_radar_results(&scanner, 3, radar_results);
+    print_test_result("A beam stops at the edge of the arena", radar_results.size() == 3);
+
+    std::cout << "\t*** Radar beam footprint testing complete ***\n\n";
+}
@@ -17,6 +17,31 @@ public:
     void test_grenade_damage();
     void test_radar();
     void test_radar_local();
+    void test_robot_index();
+    void test_railgun_path();
+    void test_flame_stencil();
+    void test_area_queries();
+    void test_board_layers();
+    void test_free_runs();
+    void test_robot_table();
+    void test_turn_events();
+    void test_log_sink();
+    void test_log_levels();
+    void test_compressed_log();
+    void test_replay();
+    void test_board_renderer();
+    void test_live_view();
+    void test_viewport();
+    void test_frame_export();
+    void test_spectator_feed();
+    void test_random_streams();
+    void test_tournament();
+    void test_forked_tournament();
+    void test_tournament_daemon();
+    void test_match_cache();
+    void test_tournament_journal();
+    void test_out_of_range_shot();
+    void test_radar_footprints();
 
 private:
     void print_test_result(const std::string& test_name, bool condition);
@@ -0,0 +1,250 @@
+#include "Tournament.h"
+#include "Arena.h"
+#include <thread>
+#include <memory>
+#include <algorithm>
+
+Tournament::Tournament(const std::vector<RobotFactory>& factories, int threads, int round_limit)
+    : m_factories(factories), m_threads(threads), m_round_limit(round_limit)
+{
+    if (m_threads <= 0)
+    {
+        m_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+}
+
+bool Tournament::take_front(JobRange& jobs, std::uint32_t& job)
+{
+    std::uint64_t range = jobs.range.load(std::memory_order_acquire);
+    while (true)
+    {
+        std::uint32_t front = static_cast<std::uint32_t>(range >> 32), back = static_cast<std::uint32_t>(range);
+        if (front >= back)
+        {
+            return false;
+        }
+        if (jobs.range.compare_exchange_weak(range, (static_cast<std::uint64_t>(front + 1) << 32) | back, std::memory_order_acq_rel))
+        {
+            job = front;
+            return true;
+        }
+    }
+}
+
+bool Tournament::take_back(JobRange& jobs, std::uint32_t& job)
+{
+    std::uint64_t range = jobs.range.load(std::memory_order_acquire);
+    while (true)
+    {
+        std::uint32_t front = static_cast<std::uint32_t>(range >> 32), back = static_cast<std::uint32_t>(range);
+        if (front >= back)
+        {
+            return false;
+        }
+        if (jobs.range.compare_exchange_weak(range, (static_cast<std::uint64_t>(front) << 32) | (back - 1), std::memory_order_acq_rel))
+        {
+            job = back - 1;
+            return true;
+        }
+    }
+}
+
+std::vector<MatchResult> Tournament::run(const std::vector<MatchJob>& jobs, const Finished& finished)
+{
+    std::vector<MatchResult> results(jobs.size());
+    const int workers = static_cast<int>(std::min<std::size_t>(m_threads, std::max<std::size_t>(jobs.size(), 1)));
+
+    // an even share each, the first few get one more
+    std::vector<JobRange> ranges(workers);
+    const std::size_t share = jobs.size() / workers, extra = jobs.size() % workers;
+    std::size_t next = 0;
+    for (int w = 0; w < workers; ++w)
+    {
+        std::size_t count = share + (static_cast<std::size_t>(w) < extra ? 1 : 0);
+        ranges[w].range.store((static_cast<std::uint64_t>(next) << 32) | (next + count), std::memory_order_relaxed);
+        next += count;
+    }
+
+    std::vector<std::size_t> stolen(workers, 0);
+    auto work = [&](int me) {
+        std::uint32_t job;
+        while (true)
+        {
+            if (take_front(ranges[me], job))
+            {
+                results[job] = play(jobs[job], nullptr, job);
+                if (finished)
+                {
+                    finished(job, results[job]);
+                }
+                continue;
+            }
+            // out of our own, look around the others starting with the next one along
+            bool found = false;
+            for (int step = 1; step < workers && !found; ++step)
+            {
+                found = take_back(ranges[(me + step) % workers], job);
+            }
+            if (!found)
+            {
+                return;     // nobody has anything left
+            }
+            ++stolen[me];
+            results[job] = play(jobs[job], nullptr, job);
+            if (finished)
+            {
+                finished(job, results[job]);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int w = 1; w < workers; ++w)
+    {
+        threads.emplace_back(work, w);
+    }
+    work(0);
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    m_steals = 0;
+    for (std::size_t count : stolen)
+    {
+        m_steals += count;
+    }
+    return results;
+}
+
+MatchResult Tournament::play(const MatchJob& job, std::atomic<int>* turn, std::size_t number) const
+{
+    Arena arena(job.rows, job.cols, job.seed);
+    LogOptions quiet;
+    quiet.level = LogLevel::off;
+    quiet.console = false;
+    quiet.file = false;
+    arena.set_log_options(quiet);
+    arena.set_round_limit(m_round_limit);
+    arena.initialize_board();
+
+    arena.set_turn_marker(turn);
+    if (m_checkpoint_every > 0 && m_checkpoint)
+    {
+        arena.set_round_hook([&](int round) {
+            if (round > 0 && round % m_checkpoint_every == 0)
+            {
+                m_checkpoint(number, round, arena);
+            }
+        });
+    }
+
+    std::vector<std::unique_ptr<RobotBase>> robots;
+    for (std::size_t slot = 0; slot < job.roster.size(); ++slot)
+    {
+        const RobotFactory& factory = m_factories[job.roster[slot]];
+        if (turn)
+        {
+            turn->store(static_cast<int>(slot), std::memory_order_relaxed);   // the constructor is robot code too
+        }
+        robots.emplace_back(factory.create());
+        if (!robots.back())
+        {
+            // a library that couldn't make its robot loses the match without it being played
+            MatchResult result;
+            result.forfeit = job.roster[slot];
+            result.health.assign(job.roster.size(), 0);
+            if (turn)
+            {
+                turn->store(-1, std::memory_order_relaxed);
+            }
+            return result;
+        }
+        int row, col;
+        arena.place_robot(robots.back().get(), factory.name, row, col);
+    }
+    if (turn)
+    {
+        turn->store(-1, std::memory_order_relaxed);
+    }
+    arena.run_simulation();
+
+    MatchResult result;
+    result.winner = arena.winning_robot() >= 0 ? job.roster[arena.winning_robot()] : -1;
+    result.rounds = arena.rounds_played();
+    for (std::size_t slot = 0; slot < job.roster.size(); ++slot)
+    {
+        result.health.push_back(arena.final_health(static_cast<int>(slot)));
+    }
+    return result;
+}
+
+std::vector<Standing> Tournament::standings(const std::vector<MatchJob>& jobs, const std::vector<MatchResult>& results) const
+{
+    std::vector<Standing> table(m_factories.size());
+    for (std::size_t who = 0; who < m_factories.size(); ++who)
+    {
+        table[who].name = m_factories[who].name;
+    }
+    for (std::size_t match = 0; match < jobs.size(); ++match)
+    {
+        const std::vector<int>& roster = jobs[match].roster;
+        for (std::size_t slot = 0; slot < roster.size(); ++slot)
+        {
+            Standing& standing = table[roster[slot]];
+            ++standing.matches;
+            standing.health_left += std::max(results[match].health[slot], 0);
+        }
+        if (results[match].winner >= 0)
+        {
+            ++table[results[match].winner].wins;
+        }
+        if (results[match].forfeit >= 0)
+        {
+            ++table[results[match].forfeit].forfeits;
+        }
+    }
+    std::stable_sort(table.begin(), table.end(), [](const Standing& a, const Standing& b) {
+        return a.wins != b.wins ? a.wins > b.wins : a.health_left > b.health_left;
+    });
+    return table;
+}
+
+std::vector<MatchJob> Tournament::free_for_all(int robots, int rows, int cols, std::uint32_t first_seed, int seeds)
+{
+    MatchJob job;
+    job.rows = rows;
+    job.cols = cols;
+    for (int who = 0; who < robots; ++who)
+    {
+        job.roster.push_back(who);
+    }
+    std::vector<MatchJob> jobs;
+    for (int i = 0; i < seeds; ++i)
+    {
+        job.seed = first_seed + static_cast<std::uint32_t>(i);
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
+std::vector<MatchJob> Tournament::pairings(int robots, int rows, int cols, std::uint32_t first_seed, int seeds)
+{
+    std::vector<MatchJob> jobs;
+    for (int i = 0; i < seeds; ++i)
+    {
+        for (int a = 0; a < robots; ++a)
+        {
+            for (int b = a + 1; b < robots; ++b)
+            {
+                MatchJob job;
+                job.roster = {a, b};
+                job.rows = rows;
+                job.cols = cols;
+                job.seed = first_seed + static_cast<std::uint32_t>(i);
+                jobs.push_back(job);
+            }
+        }
+    }
+    return jobs;
+}
@@ -0,0 +1,97 @@
+#ifndef __TOURNAMENT_H__
+#define __TOURNAMENT_H__
+
+#include "RobotLibrary.h"
+#include <vector>
+#include <string>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+class Arena;
+
+// One match of a tournament: who plays (indexes into the factories), on what board, with
+// which seed. The seed decides the obstacles, where everybody starts and every damage roll,
+// so a job plays out the same whichever thread gets it.
+struct MatchJob {
+    std::vector<int> roster;
+    int rows = 20, cols = 20;
+    std::uint32_t seed = 0;
+};
+
+struct MatchResult {
+    int winner = -1;            // index into the factories, -1 if nobody was left standing alone
+    int rounds = 0;
+    std::vector<int> health;    // by roster position, at the end
+    int forfeit = -1;           // index into the factories of a robot that crashed or hung the match
+};
+
+// how one robot did over the whole tournament
+struct Standing {
+    std::string name;
+    int matches = 0, wins = 0;
+    int forfeits = 0;           // matches it crashed or hung
+    long long health_left = 0;  // summed over its matches, to break ties
+};
+
+// Plays lots of matches at once, each in an Arena of its own with robots of its own, and
+// nothing written anywhere.
+//
+// The jobs are handed out like this: every worker starts with an even share, as a range of
+// job numbers packed into one atomic word. A worker takes jobs off the front of its own
+// range; once that's empty it takes them off the back of somebody else's. Taking a job is
+// one compare-and-swap, so nobody ever waits on a lock, and a worker that drew the long
+// matches gets helped out by the ones that didn't. Each result goes in its own slot, so
+// they're only gathered up after the workers are done.
+class Tournament
+{
+public:
+    // threads 0: one per core
+    Tournament(const std::vector<RobotFactory>& factories, int threads = 0, int round_limit = 1000);
+
+    // 'finished' (if there is one) hears about each match as soon as it's over, on whichever
+    // worker thread played it
+    using Finished = std::function<void(std::size_t job, const MatchResult& result)>;
+    std::vector<MatchResult> run(const std::vector<MatchJob>& jobs, const Finished& finished = nullptr);
+
+    // one match, on the calling thread. 'turn' gets the roster position of the robot whose
+    // code is running (see Arena::set_turn_marker), -1 when it's nobody's. 'number' is the
+    // job's number, for the checkpoint callback.
+    MatchResult play(const MatchJob& job, std::atomic<int>* turn = nullptr, std::size_t number = 0) const;
+
+    // every 'every' rounds of every match, 'checkpoint' gets a look at the arena before the
+    // round starts (on the thread or in the process playing it). 0 turns it off.
+    using Checkpoint = std::function<void(std::size_t job, int round, const Arena& arena)>;
+    void set_checkpoints(int every, Checkpoint checkpoint) { m_checkpoint_every = every; m_checkpoint = std::move(checkpoint); }
+
+    const std::vector<RobotFactory>& factories() const { return m_factories; }
+    int round_limit() const { return m_round_limit; }
+
+    std::vector<Standing> standings(const std::vector<MatchJob>& jobs, const std::vector<MatchResult>& results) const;
+
+    int threads() const { return m_threads; }
+    std::size_t steals() const { return m_steals; }     // jobs a worker took from another one in the last run()
+
+    // every robot in one match, for each of 'seeds' seeds from 'first_seed' on
+    static std::vector<MatchJob> free_for_all(int robots, int rows, int cols, std::uint32_t first_seed, int seeds);
+    // every pair of robots, for each seed
+    static std::vector<MatchJob> pairings(int robots, int rows, int cols, std::uint32_t first_seed, int seeds);
+
+private:
+    const std::vector<RobotFactory>& m_factories;
+    int m_threads;
+    int m_round_limit;
+    std::size_t m_steals = 0;
+    int m_checkpoint_every = 0;
+    Checkpoint m_checkpoint;
+
+    // a worker's jobs, [front, back) packed as front << 32 | back
+    struct alignas(64) JobRange {
+        std::atomic<std::uint64_t> range{0};
+    };
+    static bool take_front(JobRange& jobs, std::uint32_t& job);
+    static bool take_back(JobRange& jobs, std::uint32_t& job);
+};
+
+#endif
@@ -0,0 +1,475 @@
+#include "TournamentDaemon.h"
+#include "Arena.h"
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+// the biggest request anybody gets to send, the most matches one may ask for, and the
+// biggest board
+static const std::size_t max_request = 64 * 1024;
+static const std::size_t max_matches = 1000000;
+static const unsigned long long max_side = 1000;
+
+// "12" - a number of up to 'digits' digits
+static bool read_number(const std::string& value, std::size_t digits, unsigned long long& number)
+{
+    if (value.empty() || value.size() > digits || value.find_first_not_of("0123456789") != std::string::npos)
+    {
+        return false;
+    }
+    number = std::stoull(value);
+    return true;
+}
+
+static bool fill_address(const std::string& path, sockaddr_un& address)
+{
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path))
+    {
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+    return true;
+}
+
+// all of 'line', unless the other end has gone away
+static bool send_all(int socket, const std::string& line)
+{
+    std::size_t sent = 0;
+    while (sent < line.size())
+    {
+        ssize_t n = ::send(socket, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;
+        }
+        sent += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+TournamentDaemon::TournamentDaemon(const std::vector<RobotFactory>& factories, int threads, int round_limit)
+    : m_factories(factories), m_threads(threads), m_round_limit(round_limit)
+{
+    if (m_threads <= 0)
+    {
+        m_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    for (int w = 0; w < m_threads; ++w)
+    {
+        m_workers.emplace_back([this]() { work(); });
+    }
+}
+
+TournamentDaemon::~TournamentDaemon()
+{
+    stop();
+    reap_clients(true);
+    if (m_listener >= 0)
+    {
+        ::close(m_listener);
+        ::unlink(m_path.c_str());
+    }
+    {
+        std::lock_guard<std::mutex> hold(m_pool_lock);
+        m_pool_stopping = true;
+    }
+    m_work.notify_all();
+    for (std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+// one of the pool: the next match of the batch whose turn it is, and that batch goes to the
+// back of the line if it has more
+void TournamentDaemon::work()
+{
+    std::unique_lock<std::mutex> hold(m_pool_lock);
+    while (true)
+    {
+        m_work.wait(hold, [this]() { return m_pool_stopping || !m_waiting.empty(); });
+        if (m_waiting.empty())
+        {
+            return;
+        }
+        std::shared_ptr<Batch> batch = m_waiting.front();
+        m_waiting.pop_front();
+        const std::size_t job = batch->next++;
+        if (batch->next < batch->jobs.size())
+        {
+            m_waiting.push_back(batch);
+        }
+
+        hold.unlock();
+        MatchResult result = batch->tournament.play(batch->jobs[job], nullptr, job);
+        batch->finished(job, result);
+        hold.lock();
+
+        --batch->unfinished;
+        m_batch_done.notify_all();
+    }
+}
+
+bool TournamentDaemon::listen(const std::string& path)
+{
+    sockaddr_un address;
+    if (!fill_address(path, address))
+    {
+        return false;
+    }
+
+    // somebody answering there already keeps it; a socket nobody answers is left over. Only
+    // ever a socket gets removed: a path that's a typo for somebody's file is left alone.
+    struct stat there;
+    if (::lstat(path.c_str(), &there) == 0 && !S_ISSOCK(there.st_mode))
+    {
+        return false;
+    }
+    int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe < 0)
+    {
+        return false;
+    }
+    bool taken = ::connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    ::close(probe);
+    if (taken)
+    {
+        return false;
+    }
+    ::unlink(path.c_str());
+
+    m_listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_listener < 0)
+    {
+        return false;
+    }
+    if (::bind(m_listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(m_listener, 64) != 0)
+    {
+        ::close(m_listener);
+        m_listener = -1;
+        return false;
+    }
+    m_path = path;
+    return true;
+}
+
+void TournamentDaemon::serve()
+{
+    while (m_listener >= 0 && !m_stopping.load(std::memory_order_acquire))
+    {
+        pollfd ready{m_listener, POLLIN, 0};
+        if (::poll(&ready, 1, 100) > 0)
+        {
+            int socket = ::accept4(m_listener, nullptr, nullptr, SOCK_CLOEXEC);
+            if (socket >= 0)
+            {
+                m_clients.push_back(std::make_unique<Client>());
+                Client* client = m_clients.back().get();
+                client->thread = std::thread([this, client, socket]() {
+                    converse(socket);
+                    client->finished.store(true, std::memory_order_release);
+                });
+            }
+        }
+        reap_clients(false);
+    }
+    if (m_listener >= 0)
+    {
+        // nobody new gets in while the ones already here finish up
+        ::close(m_listener);
+        ::unlink(m_path.c_str());
+        m_listener = -1;
+    }
+    reap_clients(true);
+}
+
+void TournamentDaemon::reap_clients(bool all)
+{
+    for (auto client = m_clients.begin(); client != m_clients.end();)
+    {
+        if (all || (*client)->finished.load(std::memory_order_acquire))
+        {
+            (*client)->thread.join();
+            client = m_clients.erase(client);
+        }
+        else
+        {
+            ++client;
+        }
+    }
+}
+
+// one client's requests, until it hangs up, or goes quiet once the daemon is stopping
+void TournamentDaemon::converse(int socket)
+{
+    // the pool's threads reply too
+    std::atomic<bool> connected{true};
+    Reply reply = [&](const std::string& line) {
+        if (connected.load(std::memory_order_relaxed) && !send_all(socket, line + "\n"))
+        {
+            connected.store(false, std::memory_order_relaxed);
+        }
+    };
+    // hung up altogether; one that's only done sending still wants its answers
+    HungUp hung_up = [&]() {
+        pollfd gone{socket, 0, 0};
+        return !connected.load(std::memory_order_relaxed) || (::poll(&gone, 1, 0) > 0 && (gone.revents & (POLLHUP | POLLERR)));
+    };
+
+    std::string pending;
+    char buffer[4096];
+    while (connected)
+    {
+        std::size_t end = pending.find('\n');
+        if (end != std::string::npos)
+        {
+            std::string request = pending.substr(0, end);
+            pending.erase(0, end + 1);
+            if (!request.empty() && request.back() == '\r')
+            {
+                request.pop_back();
+            }
+            if (!answer(request, reply, hung_up))
+            {
+                stop();
+                break;
+            }
+            continue;
+        }
+        if (pending.size() > max_request)
+        {
+            reply("error request too long");
+            break;
+        }
+
+        pollfd ready{socket, POLLIN, 0};
+        int events = ::poll(&ready, 1, 100);
+        if (events == 0)
+        {
+            if (m_stopping.load(std::memory_order_acquire))
+            {
+                break;
+            }
+            continue;
+        }
+        ssize_t n = events > 0 ? ::recv(socket, buffer, sizeof(buffer), 0) : -1;
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            break;
+        }
+        pending.append(buffer, static_cast<std::size_t>(n));
+    }
+    ::close(socket);
+}
+
+bool TournamentDaemon::read_roster(const std::string& names, std::vector<int>& roster, std::string& why) const
+{
+    roster.clear();
+    if (names == "all")
+    {
+        for (std::size_t who = 0; who < m_factories.size(); ++who)
+        {
+            roster.push_back(static_cast<int>(who));
+        }
+        return true;
+    }
+    std::istringstream list(names);
+    std::string name;
+    while (std::getline(list, name, ','))
+    {
+        std::size_t who = 0;
+        while (who < m_factories.size() && m_factories[who].name != name)
+        {
+            ++who;
+        }
+        if (who == m_factories.size())
+        {
+            why = "unknown robot " + name;
+            return false;
+        }
+        roster.push_back(static_cast<int>(who));
+    }
+    return true;
+}
+
+bool TournamentDaemon::answer(const std::string& request, const Reply& reply, const HungUp& hung_up)
+{
+    std::istringstream words(request);
+    std::string verb;
+    words >> verb;
+
+    if (verb.empty())
+    {
+        return true;
+    }
+    if (verb == "shutdown")
+    {
+        reply("bye");
+        return false;
+    }
+    if (verb == "robots")
+    {
+        for (std::size_t who = 0; who < m_factories.size(); ++who)
+        {
+            reply("robot " + std::to_string(who) + " " + m_factories[who].name);
+        }
+        reply("done " + std::to_string(m_factories.size()));
+        return true;
+    }
+    if (verb != "play")
+    {
+        reply("error unknown request " + verb);
+        return true;
+    }
+
+    std::vector<int> roster;
+    bool have_roster = false, pairs = false;
+    int rows = 20, cols = 20, round_limit = m_round_limit;
+    std::uint32_t seed = 1;
+    unsigned long long seeds = 1;
+    std::string word, why;
+    while (words >> word)
+    {
+        std::size_t equals = word.find('=');
+        std::string key = word.substr(0, equals), value = equals == std::string::npos ? "" : word.substr(equals + 1);
+        unsigned long long number = 0;
+        if (word == "pairs")
+        {
+            pairs = true;
+        }
+        else if (key == "roster")
+        {
+            have_roster = read_roster(value, roster, why);
+            if (!have_roster)
+            {
+                reply("error " + why);
+                return true;
+            }
+        }
+        else if (key == "size")
+        {
+            std::size_t split = value.find('x');
+            unsigned long long r = 0, c = 0;
+            if (split == std::string::npos || !read_number(value.substr(0, split), 4, r) || !read_number(value.substr(split + 1), 4, c)
+                || r < 1 || c < 1 || r > max_side || c > max_side)
+            {
+                reply("error bad size " + value);
+                return true;
+            }
+            rows = static_cast<int>(r);
+            cols = static_cast<int>(c);
+        }
+        else if (key == "seed" && read_number(value, 10, number) && number <= UINT32_MAX)
+        {
+            seed = static_cast<std::uint32_t>(number);
+        }
+        else if (key == "seeds" && read_number(value, 7, number) && number > 0)
+        {
+            seeds = number;
+        }
+        else if (key == "rounds" && read_number(value, 9, number) && number > 0)
+        {
+            round_limit = static_cast<int>(number);
+        }
+        else
+        {
+            reply("error bad argument " + word);
+            return true;
+        }
+    }
+    if (!have_roster || roster.empty() || (pairs && roster.size() < 2))
+    {
+        reply(pairs ? "error pairs needs two robots or more" : "error no roster");
+        return true;
+    }
+
+    // every robot and every obstacle there could be has to fit, or placing them never ends
+    const std::size_t cells = static_cast<std::size_t>(rows) * cols;
+    if (cells <= static_cast<std::size_t>(Arena::max_obstacles(rows, cols)) + roster.size())
+    {
+        reply("error board too small for the roster");
+        return true;
+    }
+
+    const std::size_t robots = roster.size();
+    if (seeds * (pairs ? robots * (robots - 1) / 2 : 1) > max_matches)
+    {
+        reply("error more than " + std::to_string(max_matches) + " matches");
+        return true;
+    }
+
+    // the jobs, with the roster positions turned into factory numbers
+    std::vector<MatchJob> jobs = pairs ? Tournament::pairings(static_cast<int>(robots), rows, cols, seed, static_cast<int>(seeds))
+                                       : Tournament::free_for_all(static_cast<int>(robots), rows, cols, seed, static_cast<int>(seeds));
+    for (MatchJob& job : jobs)
+    {
+        for (int& who : job.roster)
+        {
+            who = roster[who];
+        }
+    }
+
+    // the workers finish matches whenever they do, so the lines go out one at a time
+    std::mutex replying;
+    auto batch = std::make_shared<Batch>(m_factories, round_limit);
+    batch->jobs = std::move(jobs);
+    batch->unfinished = batch->jobs.size();
+    batch->finished = [&, batch = batch.get()](std::size_t number, const MatchResult& result) {
+        const MatchJob& job = batch->jobs[number];
+        std::string names, health;
+        for (std::size_t slot = 0; slot < job.roster.size(); ++slot)
+        {
+            names += (slot ? "," : "") + m_factories[job.roster[slot]].name;
+            health += (slot ? "," : "") + std::to_string(result.health[slot]);
+        }
+        std::string line = "result " + std::to_string(number) + " seed=" + std::to_string(job.seed) + " roster=" + names
+                         + " winner=" + (result.winner >= 0 ? m_factories[result.winner].name : std::string("none"))
+                         + " rounds=" + std::to_string(result.rounds) + " health=" + health;
+        std::lock_guard<std::mutex> hold(replying);
+        reply(line);
+    };
+
+    std::unique_lock<std::mutex> hold(m_pool_lock);
+    m_waiting.push_back(batch);
+    m_work.notify_all();
+    bool dropped = false;
+    while (batch->unfinished > 0)
+    {
+        m_batch_done.wait_for(hold, std::chrono::milliseconds(100));
+        if (!dropped && hung_up && hung_up())
+        {
+            // nobody to tell: what hasn't started never will, and what has is waited for
+            auto waiting = std::find(m_waiting.begin(), m_waiting.end(), batch);
+            if (waiting != m_waiting.end())
+            {
+                m_waiting.erase(waiting);
+                batch->unfinished -= batch->jobs.size() - batch->next;
+                batch->next = batch->jobs.size();
+            }
+            dropped = true;
+        }
+    }
+    hold.unlock();
+    if (!dropped)
+    {
+        reply("done " + std::to_string(batch->jobs.size()));
+    }
+    return true;
+}
@@ -0,0 +1,99 @@
+#ifndef __TOURNAMENTDAEMON_H__
+#define __TOURNAMENTDAEMON_H__
+
+#include "Tournament.h"
+#include <string>
+#include <vector>
+#include <list>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+
+// Plays matches for whoever connects to a Unix domain socket. The robot libraries are
+// compiled and loaded once, when the daemon starts, so a request costs only its matches.
+//
+// A request is one line, and the answer is one line per match as each one finishes (in
+// whatever order that is) and then a last line that says it's over:
+//
+//   robots
+//       robot <number> <name>          for each robot
+//       done <robots>
+//   play roster=<name>,<name>... [size=RxC] [seed=N] [seeds=N] [pairs] [rounds=N]
+//       roster=all is everybody. The board is 20x20 and the seed 1 unless they're given;
+//       seeds=N plays seeds seed .. seed + N - 1. pairs plays every pair out of the
+//       roster instead of the whole roster at once.
+//       result <job> seed=<seed> roster=<names> winner=<name|none> rounds=<n> health=<h>,<h>...
+//       done <matches>
+//   shutdown
+//       bye                            and the daemon stops taking clients; the ones
+//                                      still connected get their requests answered
+//
+// Anything else gets "error <why>". One client can send as many requests as it likes; each
+// connection is served on a thread of its own. The matches are all played by one pool of
+// the daemon's worker threads, whoever asked for them: the requests waiting take turns,
+// a match each, so a big one doesn't hold up everybody who came after it. A client that
+// hangs up has the rest of its matches dropped (the ones already being played finish).
+class TournamentDaemon
+{
+public:
+    // threads 0: one per core, shared by every request
+    TournamentDaemon(const std::vector<RobotFactory>& factories, int threads = 0, int round_limit = 1000);
+    ~TournamentDaemon();
+
+    // binds and listens on 'path', taking the place of a socket left behind by a daemon
+    // that's gone, but not of one that's still answering, nor of anything that isn't a socket
+    bool listen(const std::string& path);
+
+    // takes clients until somebody sends shutdown (or stop() is called), then waits for
+    // the requests already going to be answered and removes the socket
+    void serve();
+    void stop() { m_stopping.store(true, std::memory_order_release); }
+
+    // the answer to one request, a line at a time through 'reply'; false once it's shutdown.
+    // While its matches are being played, 'hung_up' (if there is one) is asked now and then
+    // whether anybody's still listening, and if not the ones not started yet are dropped.
+    using Reply = std::function<void(const std::string& line)>;
+    using HungUp = std::function<bool()>;
+    bool answer(const std::string& request, const Reply& reply, const HungUp& hung_up = nullptr);
+
+private:
+    const std::vector<RobotFactory>& m_factories;
+    int m_threads;
+    int m_round_limit;
+    std::string m_path;
+    int m_listener = -1;
+    std::atomic<bool> m_stopping{false};
+
+    struct Client {
+        std::thread thread;
+        std::atomic<bool> finished{false};
+    };
+    std::list<std::unique_ptr<Client>> m_clients;
+
+    // one request's matches, while they're played
+    struct Batch {
+        std::vector<MatchJob> jobs;
+        Tournament tournament;
+        Tournament::Finished finished;
+        std::size_t next = 0;           // the first not handed to a worker yet
+        std::size_t unfinished;         // handed out and not over, or not handed out
+        Batch(const std::vector<RobotFactory>& factories, int round_limit) : tournament(factories, 1, round_limit) {}
+    };
+    // the pool, and the batches with matches left to hand out, in turn
+    std::vector<std::thread> m_workers;
+    std::deque<std::shared_ptr<Batch>> m_waiting;
+    std::mutex m_pool_lock;
+    std::condition_variable m_work, m_batch_done;
+    bool m_pool_stopping = false;
+
+    void work();
+    void converse(int socket);
+    void reap_clients(bool all);
+    bool read_roster(const std::string& names, std::vector<int>& roster, std::string& why) const;
+};
+
+#endif
@@ -0,0 +1,302 @@
+#include "TournamentJournal.h"
+#include "MatchCache.h"
+#include <sstream>
+#include <fstream>
+#include <iterator>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <zlib.h>
+
+static std::string hex(std::uint64_t value)
+{
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value));
+    return text;
+}
+
+static std::string to_hex(const std::string& bytes)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string text;
+    text.reserve(bytes.size() * 2);
+    for (unsigned char byte : bytes)
+    {
+        text += digits[byte >> 4];
+        text += digits[byte & 15];
+    }
+    return text;
+}
+
+static int nibble(char digit)
+{
+    if (digit >= '0' && digit <= '9')
+        return digit - '0';
+    if (digit >= 'a' && digit <= 'f')
+        return digit - 'a' + 10;
+    return -1;
+}
+
+static bool from_hex(const std::string& text, std::string& bytes)
+{
+    if (text.size() % 2)
+    {
+        return false;
+    }
+    bytes.clear();
+    bytes.reserve(text.size() / 2);
+    for (std::size_t i = 0; i < text.size(); i += 2)
+    {
+        int high = nibble(text[i]), low = nibble(text[i + 1]);
+        if (high < 0 || low < 0)
+        {
+            return false;
+        }
+        bytes += static_cast<char>(high * 16 + low);
+    }
+    return true;
+}
+
+// the states are mostly empty cells, so they shrink a lot
+static std::string squeeze(const std::string& bytes)
+{
+    uLongf size = compressBound(bytes.size());
+    std::string out(size, '\0');
+    if (compress2(reinterpret_cast<Bytef*>(out.data()), &size, reinterpret_cast<const Bytef*>(bytes.data()), bytes.size(), Z_BEST_SPEED) != Z_OK)
+    {
+        return "";
+    }
+    out.resize(size);
+    return out;
+}
+
+static bool unsqueeze(const std::string& squeezed, std::size_t size, std::string& bytes)
+{
+    bytes.assign(size, '\0');
+    uLongf got = size;
+    return uncompress(reinterpret_cast<Bytef*>(bytes.data()), &got, reinterpret_cast<const Bytef*>(squeezed.data()), squeezed.size()) == Z_OK
+        && got == size;
+}
+
+TournamentJournal::TournamentJournal(const std::string& file, int sync_ms)
+    : m_file(file), m_sync_ms(sync_ms)
+{
+    // it comes zeroed, so both counts start at 0
+    void* shared = ::mmap(nullptr, sizeof(Counts), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    m_counts = shared == MAP_FAILED ? &m_unshared : static_cast<Counts*>(shared);
+}
+
+TournamentJournal::~TournamentJournal()
+{
+    // a forked copy doesn't have the thread, only the parent does
+    if (m_syncer.joinable() && ::getpid() == m_owner)
+    {
+        {
+            std::lock_guard<std::mutex> hold(m_lock);
+            m_stopping = true;
+        }
+        m_wake.notify_one();
+        m_syncer.join();
+    }
+    if (m_fd >= 0)
+    {
+        ::fdatasync(m_fd);
+        ::close(m_fd);
+    }
+    if (m_counts != &m_unshared)
+    {
+        ::munmap(m_counts, sizeof(Counts));
+    }
+}
+
+std::uint64_t TournamentJournal::identify(const std::vector<MatchJob>& jobs, int round_limit)
+{
+    std::uint64_t h = MatchCache::hash(&round_limit, sizeof(round_limit));
+    for (const MatchJob& job : jobs)
+    {
+        const std::int64_t fields[3] = {job.rows, job.cols, job.seed};
+        h = MatchCache::hash(fields, sizeof(fields), h);
+        h = MatchCache::hash(job.roster.data(), job.roster.size() * sizeof(int), h);
+    }
+    return h;
+}
+
+bool TournamentJournal::start(std::uint64_t tournament, std::size_t jobs)
+{
+    m_done.clear();
+    m_checkpoints.clear();
+    m_fd = ::open(m_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (m_fd < 0)
+    {
+        return false;
+    }
+    append("journal " + hex(tournament) + " " + std::to_string(jobs));
+    ::fdatasync(m_fd);
+    open_syncer();
+    return true;
+}
+
+bool TournamentJournal::resume(std::uint64_t tournament, std::size_t jobs)
+{
+    if (::access(m_file.c_str(), F_OK) != 0)
+    {
+        return start(tournament, jobs);     // nothing to pick up
+    }
+    off_t good = 0;
+    if (!read_back(tournament, jobs, good))
+    {
+        return false;
+    }
+    if (good == 0)
+    {
+        return start(tournament, jobs);     // it never got as far as a whole header
+    }
+    m_fd = ::open(m_file.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (m_fd < 0 || ::ftruncate(m_fd, good) != 0)
+    {
+        return false;
+    }
+    open_syncer();
+    return true;
+}
+
+bool TournamentJournal::read_back(std::uint64_t tournament, std::size_t jobs, off_t& good)
+{
+    std::ifstream in(m_file, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    std::size_t at = 0;
+    bool header = false;
+    while (true)
+    {
+        std::size_t end = contents.find('\n', at);
+        std::size_t split = end == std::string::npos ? end : contents.rfind(' ', end);
+        if (end == std::string::npos || split == std::string::npos || split < at)
+        {
+            break;
+        }
+        const std::string text = contents.substr(at, split - at);
+        if (contents.substr(split + 1, end - split - 1) != hex(MatchCache::hash(text.data(), text.size())))
+        {
+            break;
+        }
+
+        std::istringstream words(text);
+        std::string tag;
+        words >> tag;
+        if (!header)
+        {
+            std::string which;
+            std::size_t count = 0;
+            words >> which >> count;
+            if (tag != "journal" || which != hex(tournament) || count != jobs)
+            {
+                return false;   // somebody else's tournament
+            }
+            header = true;
+        }
+        else if (tag == "done")
+        {
+            std::size_t job = 0, health = 0;
+            MatchResult result;
+            words >> job >> result.winner >> result.rounds >> result.forfeit >> health;
+            if (!words || health > 4096)
+            {
+                break;
+            }
+            result.health.resize(health);
+            for (int& h : result.health)
+            {
+                words >> h;
+            }
+            if (!words || job >= jobs)
+            {
+                break;
+            }
+            m_done[job] = result;
+        }
+        else if (tag == "checkpoint")
+        {
+            std::size_t job = 0, size = 0;
+            int round = 0;
+            std::string state, squeezed, bytes;
+            words >> job >> round >> size >> state;
+            if (!words || job >= jobs || size > (1u << 26) || !from_hex(state, squeezed) || !unsqueeze(squeezed, size, bytes))
+            {
+                break;
+            }
+            m_checkpoints[{job, round}] = bytes;
+        }
+        else
+        {
+            break;
+        }
+        at = end + 1;
+    }
+    good = header ? static_cast<off_t>(at) : 0;
+
+    // the checkpoints that matter are the ones for matches that never finished
+    for (auto checkpoint = m_checkpoints.begin(); checkpoint != m_checkpoints.end();)
+    {
+        checkpoint = m_done.count(checkpoint->first.first) ? m_checkpoints.erase(checkpoint) : std::next(checkpoint);
+    }
+    return true;
+}
+
+void TournamentJournal::open_syncer()
+{
+    m_owner = ::getpid();
+    m_syncer = std::thread([this]() {
+        std::unique_lock<std::mutex> hold(m_lock);
+        while (!m_stopping)
+        {
+            m_wake.wait_for(hold, std::chrono::milliseconds(m_sync_ms));
+            ::fdatasync(m_fd);
+        }
+    });
+}
+
+// one write, so it lands in one piece wherever it comes from. It's called in forked
+// workers too, so it's only ever the descriptor: no lock, and not stdio either.
+void TournamentJournal::append(std::string line)
+{
+    line += " " + hex(MatchCache::hash(line.data(), line.size())) + "\n";
+    if (m_fd >= 0 && ::write(m_fd, line.data(), line.size()) != static_cast<ssize_t>(line.size()))
+    {
+        const std::string why = m_file + ": " + std::strerror(errno) + "\n";
+        (void)!::write(STDERR_FILENO, why.data(), why.size());
+    }
+}
+
+void TournamentJournal::finished(std::size_t job, const MatchResult& result)
+{
+    std::string line = "done " + std::to_string(job) + " " + std::to_string(result.winner) + " " + std::to_string(result.rounds)
+                     + " " + std::to_string(result.forfeit) + " " + std::to_string(result.health.size());
+    for (int h : result.health)
+    {
+        line += " " + std::to_string(h);
+    }
+    append(line);
+}
+
+void TournamentJournal::reached(std::size_t job, int round, const std::string& state)
+{
+    auto checkpoint = m_checkpoints.find({job, round});
+    if (checkpoint == m_checkpoints.end())
+    {
+        append("checkpoint " + std::to_string(job) + " " + std::to_string(round) + " " + std::to_string(state.size())
+               + " " + to_hex(squeeze(state)));
+    }
+    else if (checkpoint->second == state)
+    {
+        m_counts->verified.fetch_add(1);
+    }
+    else
+    {
+        m_counts->diverged.fetch_add(1);
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef __TOURNAMENTJOURNAL_H__
+#define __TOURNAMENTJOURNAL_H__
+
+#include "Tournament.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <sys/types.h>
+
+// Writes down a tournament as it goes, so one that was cut short can be picked up again.
+//
+// The journal is a text file that's only ever appended to, one record per line, each
+// ending in a checksum of the rest of the line:
+//   journal <tournament> <jobs>                        which tournament this is
+//   done <job> <winner> <rounds> <forfeit> <health>... a match that's over
+//   checkpoint <job> <round> <size> <state>            Arena::save_state, deflated, in hex
+// Every record is one write() on a file opened for appending, so records from different
+// threads, or from forked workers sharing the descriptor, never get mixed up. Nothing
+// waits for the disk: a thread of the journal's own syncs the file every sync_ms. A crash
+// loses at most the last sync_ms of results, and those matches just get played again.
+// A forked worker has no copy of that thread, so all it ever does with the journal is
+// write() to the descriptor (finished() and reached()); the parent does the syncing.
+//
+// Reading it back stops at the first line that's cut off or doesn't check out, and the
+// file is cut back to there before anything more gets written. One that doesn't even
+// have a whole header line is started over.
+//
+// Checkpoints aren't for restarting from. A robot's own memory can't be written down, so
+// a match can't be started from the middle: one that was being played gets played again
+// from the start, and the same seed makes it play out the same. A checkpoint checks that
+// it did: at each round it had one for, the arena is compared with it. A match whose
+// robots don't do the same things twice (one with a random generator of its own, say) has
+// its checkpoints counted as diverged.
+class TournamentJournal
+{
+public:
+    TournamentJournal(const std::string& file, int sync_ms = 200);
+    ~TournamentJournal();   // syncs whatever's left
+
+    // the tournament a journal is for: a hash of every job and the round limit
+    static std::uint64_t identify(const std::vector<MatchJob>& jobs, int round_limit);
+
+    // a new journal, replacing whatever was there
+    bool start(std::uint64_t tournament, std::size_t jobs);
+    // carries on with the journal there, which has to be for the same tournament; with no
+    // journal there, or one cut off before its header was, it's start()
+    bool resume(std::uint64_t tournament, std::size_t jobs);
+
+    // what resume() found: finished matches, and the checkpoints of ones that weren't
+    const std::map<std::size_t, MatchResult>& done() const { return m_done; }
+    std::size_t in_flight() const { return m_checkpoints.size(); }
+
+    void finished(std::size_t job, const MatchResult& result);
+
+    // a match got to 'round': checked against the checkpoint resume() found for it, or
+    // written down as a new one
+    void reached(std::size_t job, int round, const std::string& state);
+
+    // checkpoints resumed matches got back to, the same and not, in this process and in any
+    // forked from it
+    std::size_t verified() const { return m_counts->verified.load(); }
+    std::size_t diverged() const { return m_counts->diverged.load(); }
+
+private:
+    std::string m_file;
+    int m_sync_ms;
+    int m_fd = -1;
+    pid_t m_owner = -1;     // the process with the syncer thread
+    std::map<std::size_t, MatchResult> m_done;
+    std::map<std::pair<std::size_t, int>, std::string> m_checkpoints;  // by job and round
+
+    // in shared memory, so forked workers count into the same place
+    struct Counts {
+        std::atomic<std::uint64_t> verified, diverged;
+    };
+    Counts* m_counts = nullptr;
+    Counts m_unshared{};    // if the shared page couldn't be had
+
+    std::thread m_syncer;
+    std::mutex m_lock;
+    std::condition_variable m_wake;
+    bool m_stopping = false;
+
+    void append(std::string line);
+    bool read_back(std::uint64_t tournament, std::size_t jobs, off_t& good);
+    void open_syncer();
+};
+
+#endif
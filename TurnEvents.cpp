@@ -0,0 +1,164 @@
+#include "TurnEvents.h"
+
+// Define the unique characters for robots
+static const char unique_char[] = {
+    '!', '@', '#', '$', '%', '^', '&', '*', '(', ')', '-', '_', '+', '=', '{', '}', '[', ']', '|',
+    ':', ';', '"', '\'', '<', '>', ',', '.', '?', '/', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9'
+};
+
+char robot_symbol(int slot)
+{
+    if (slot < 0 || slot >= static_cast<int>(sizeof(unique_char)))
+    {
+        return '~';     // more robots than symbols - they share this one
+    }
+    return unique_char[slot];
+}
+
+static void append_location(std::string& text, int row, int col)
+{
+    text += '(';
+    text += std::to_string(row);
+    text += ',';
+    text += std::to_string(col);
+    text += ')';
+}
+
+// how print_stats() writes a weapon
+static const char* weapon_name(char weapon)
+{
+    switch (weapon)
+    {
+        case flamethrower: return "flamethrower";
+        case railgun:      return "railgun";
+        case grenade:      return "grenade";
+        case hammer:       return "hammer";
+        default:           return "unknown";
+    }
+}
+
+void format_turn_events(const std::vector<TurnEvent>& events, std::string& text)
+{
+    // what goes after each hit depends on what did the hitting
+    const char* hit_tail = "";
+
+    for (const TurnEvent& event : events)
+    {
+        const std::string& name = event.robot->m_name;
+        switch (event.type)
+        {
+            case TurnEventType::turn:
+                // the same as RobotBase::print_stats()
+                text += event.robot_id;
+                text += name + ":   H: " + std::to_string(event.health) + "  W: " + weapon_name(event.detail);
+                text += "  A: " + std::to_string(event.armor) + "  M: " + std::to_string(event.move) + "  at: ";
+                append_location(text, event.row, event.col);
+                text += ' ';
+                break;
+
+            case TurnEventType::radar:
+                text += "  checking radar, direction: " + std::to_string(event.amount) + " ... ";
+                if (event.detail == 0)
+                {
+                    text += " found nothing. ";
+                }
+                else
+                {
+                    text += " found '";
+                    text += event.detail;
+                    text += "' at ";
+                    append_location(text, event.row, event.col);
+                    text += ' ';
+                }
+                break;
+
+            case TurnEventType::shot:
+                text += "Shooting: ";
+                switch (event.detail)
+                {
+                    case flamethrower: text += " firing flamethrower... "; hit_tail = "";   break;
+                    case railgun:      text += " shooting railgun... ";    hit_tail = "  "; break;
+                    case grenade:      text += " launching grenade... ";   hit_tail = " ";  break;
+                    case hammer:       text += " pounding with the hammer..."; hit_tail = ""; break;
+                    default:           text += "strange weapon? ";         break;
+                }
+                break;
+
+            case TurnEventType::railgun_invalid:
+                text += "Invalid shot direction.";
+                break;
+
+            case TurnEventType::railgun_miss:
+                text += " railgun missed!  The universe is upside down! ";
+                break;
+
+            case TurnEventType::no_grenades:
+                text += " out of grenades. ";
+                break;
+
+            case TurnEventType::hammer_miss:
+                text += name + " hammer missed trying to hit ";
+                append_location(text, event.row, event.col);
+                text += ' ';
+                break;
+
+            case TurnEventType::move:
+                text += "Moving: ";
+                hit_tail = "";
+                break;
+
+            case TurnEventType::cannot_move:
+                text += name + " cannot move. ";
+                break;
+
+            case TurnEventType::no_move:
+                text += name + " chooses not to move.";
+                break;
+
+            case TurnEventType::collision:
+                switch (event.detail)
+                {
+                    case 'M': text += name + " is stopped by a mound at ";        break;
+                    case 'X': text += name + " is stopped by a dead robot at ";   break;
+                    case 'R': text += name + " crashes into another robot at ";   break;
+                    case 'P': text += name + " is stuck in a pit at ";            break;
+                    case 'F': text += name + " encounters a flamethrower at ";    break;
+                    default:
+                        text += "Unknown obstacle: ";
+                        text += event.detail;
+                        text += " at ";
+                        break;
+                }
+                append_location(text, event.row, event.col);
+                switch (event.detail)
+                {
+                    case 'M': case 'X': case 'R': text += ". \n";                       break;
+                    case 'P':                     text += ". Movement disabled. \n";    break;
+                    case 'F':                     text += ". Taking damage! \n";        break;
+                    default:                      text += ".\n";                        break;
+                }
+                break;
+
+            case TurnEventType::moved:
+                text += name + " moves to ";
+                append_location(text, event.row, event.col);
+                text += ' ';
+                break;
+
+            case TurnEventType::hit:
+                text += name + " takes " + std::to_string(event.amount) + " damage. Health: " + std::to_string(event.health) + "\n";
+                text += hit_tail;
+                break;
+
+            case TurnEventType::turn_end:
+                text += '\n';
+                break;
+
+            case TurnEventType::death:
+                text += name + " ";
+                text += event.robot_id;
+                text += " is out.\n";
+                break;
+        }
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef __TURNEVENTS_H__
+#define __TURNEVENTS_H__
+
+#include "RobotBase.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// What can happen during a round. The comment is what the text log says for it.
+enum class TurnEventType : std::uint8_t {
+    turn,               // <id><robot's stats>                 - a robot starts its turn
+    radar,              // checking radar, direction: ...       - what the radar found (detail 0: nothing)
+    shot,               // Shooting: <weapon>...               - detail is the weapon
+    railgun_invalid,    // Invalid shot direction.
+    railgun_miss,       // railgun missed!
+    no_grenades,        // out of grenades.
+    hammer_miss,        // <name> hammer missed trying to hit (row,col)
+    move,               // Moving:
+    cannot_move,        // <name> cannot move.
+    no_move,            // <name> chooses not to move.
+    collision,          // <name> is stopped by ... - detail is the cell it ran into
+    moved,              // <name> moves to (row,col)
+    hit,                // <name> takes <amount> damage. Health: <health>
+    turn_end,           // end of the robot's line
+    death               // <name> <id> is out.
+};
+
+// One thing that happened, as small as it can be. Which fields mean anything depends
+// on the type - see the list above.
+struct TurnEvent {
+    TurnEventType type;
+    char detail;            // weapon, obstacle or radar find
+    char robot_id;          // the robot's character on the board
+    std::int16_t row, col;
+    std::int16_t health, armor, move;
+    std::int16_t amount;    // damage, or the radar direction
+    const RobotBase* robot;
+};
+
+// Turn a round's events into the text log, appended to 'text'. This and BoardRenderer are
+// the only places the log text gets built, so runs without a text log don't format anything.
+void format_turn_events(const std::vector<TurnEvent>& events, std::string& text);
+
+// the character a robot is shown with on the board and in the log, by robot index ('~' for
+// any past the 39th)
+char robot_symbol(int slot);
+
+#endif
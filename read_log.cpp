@@ -0,0 +1,81 @@
+#include <iostream>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include "CompressedLog.h"
+
+// Reads a compressed match log (RobotWarz -compress=true) without unpacking all of it.
+//
+//   read_log RobotWarz_log.txt.gz [-from=N] [-to=N] [-grep=text]
+//
+// prints the log text of rounds N to N (all of them by default), or with -grep just the
+// lines of those rounds that have 'text' in them, each one starting with its round number.
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: read_log <log.gz> [-from=N] [-to=N] [-grep=text]" << std::endl;
+        return 1;
+    }
+
+    std::uint32_t from = 0, to = UINT32_MAX;
+    std::string pattern;
+    bool grep = false;
+
+    for (int i = 2; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg.find("-from=") == 0)
+        {
+            from = static_cast<std::uint32_t>(std::stoul(arg.substr(6)));
+        }
+        else if (arg.find("-to=") == 0)
+        {
+            to = static_cast<std::uint32_t>(std::stoul(arg.substr(4)));
+        }
+        else if (arg.find("-grep=") == 0)
+        {
+            pattern = arg.substr(6);
+            grep = true;
+        }
+        else
+        {
+            std::cerr << "Unknown argument: " << arg << ". Ignoring it." << std::endl;
+        }
+    }
+
+    int fd = ::open(argv[1], O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "Can't open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    bool ok = read_compressed_log(fd, from, to, [&](std::uint32_t round, std::string_view text) {
+        if (!grep)
+        {
+            std::fwrite(text.data(), 1, text.size(), stdout);
+            return;
+        }
+        while (!text.empty())
+        {
+            std::size_t end = text.find('\n');
+            std::string_view line = text.substr(0, end);
+            if (line.find(pattern) != std::string_view::npos)
+            {
+                std::printf("%u: %.*s\n", round, static_cast<int>(line.size()), line.data());
+            }
+            text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+        }
+    });
+    ::close(fd);
+
+    if (!ok)
+    {
+        std::cerr << argv[1] << " isn't a RobotWarz compressed log" << std::endl;
+        return 1;
+    }
+    return 0;
+}
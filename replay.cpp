@@ -0,0 +1,125 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include "Replay.h"
+#include "BoardRenderer.h"
+#include "FrameExport.h"
+
+// "12" from -round=12 or -frames=12, or -1 if it isn't a number
+static int parse_count(const std::string& arg, std::size_t at)
+{
+    std::string value = arg.substr(at);
+    if (value.empty() || value.size() > 9 || value.find_first_not_of("0123456789") != std::string::npos)
+        return -1;
+    return std::stoi(value);
+}
+
+// Looks at a recorded match (RobotWarz -replay=true) without running the robots again.
+//
+//   replay RobotWarz.replay [-round=N] [-text] [-turns] [-frames=N] [-png]
+//
+// prints the board and what happened in round N (the first one by default), or with -text
+// the whole match as the text log it would have written. -turns leaves the boards out,
+// like -log=turn does. -frames=N saves every Nth round's board as a picture in
+// replay_frames/ instead (PPM, or PNG with -png).
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: replay <file.replay> [-round=N] [-text] [-turns] [-frames=N] [-png]" << std::endl;
+        return 1;
+    }
+
+    int round = 0;
+    bool text = false, boards = true, png = false;
+    int frames_every = 0;
+
+    for (int i = 2; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg.find("-round=") == 0)
+        {
+            round = parse_count(arg, 7);
+            if (round < 0)
+            {
+                std::cerr << "Invalid value for -round. Showing the first round." << std::endl;
+                round = 0;
+            }
+        }
+        else if (arg == "-text")
+        {
+            text = true;
+        }
+        else if (arg == "-turns")
+        {
+            boards = false;
+        }
+        else if (arg.find("-frames=") == 0)
+        {
+            frames_every = parse_count(arg, 8);
+            if (frames_every <= 0)
+            {
+                std::cerr << "Invalid value for -frames. Not saving any frames." << std::endl;
+                frames_every = 0;
+            }
+        }
+        else if (arg == "-png")
+        {
+            png = true;
+        }
+        else
+        {
+            std::cerr << "Unknown argument: " << arg << ". Ignoring it." << std::endl;
+        }
+    }
+
+    Replay replay;
+    if (!replay.open(argv[1]))
+    {
+        std::cerr << argv[1] << " isn't a RobotWarz replay" << std::endl;
+        return 1;
+    }
+
+    std::string out;
+    if (frames_every > 0)
+    {
+        FrameExporter frames("replay_frames", replay.rows(), replay.cols(), png ? FrameExporter::png : FrameExporter::ppm);
+        std::vector<char> cells;
+        std::vector<int> occupant;
+        for (int round = 0; round < replay.rounds(); round += frames_every)
+        {
+            replay.board_at(round, cells, occupant);
+            frames.add_frame(round, cells.data(), occupant.data(), replay.cols());
+        }
+        frames.flush();
+        if (!frames.ok())
+        {
+            std::cerr << "Couldn't write all the frames to replay_frames/" << std::endl;
+            return 1;
+        }
+    }
+    else if (text)
+    {
+        replay.write_text(out, boards);
+    }
+    else
+    {
+        std::vector<char> cells;
+        std::vector<int> occupant;
+        std::vector<TurnEvent> events;
+        if (!replay.board_at(round, cells, occupant))
+        {
+            std::cerr << "There's no round " << round << ", the match went " << replay.rounds() << " rounds." << std::endl;
+            return 1;
+        }
+        if (boards)
+        {
+            format_board(round, replay.rows(), replay.cols(), cells.data(), occupant.data(), replay.cols(), out);
+        }
+        replay.events_at(round, events);
+        format_turn_events(events, out);
+    }
+    std::fwrite(out.data(), 1, out.size(), stdout);
+    return 0;
+}
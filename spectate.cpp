@@ -0,0 +1,135 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstdio>
+#include <chrono>
+#include <thread>
+#include "SpectatorFeed.h"
+#include "BoardRenderer.h"
+
+// Watches a running match (RobotWarz -spectate=NAME) from another terminal.
+//
+//   spectate [NAME] [-every=MS] [-once]
+//
+// NAME is /robotwarz by default. Waits for the match to start, then shows the board and
+// the robots' stats every MS milliseconds (200 by default) until it's over. -once prints
+// what's there right now and quits. Any number of these can watch the same match, and
+// they never hold the game up.
+static const char* weapon_names[] = {"flamethrower", "railgun", "grenade", "hammer"};   // by WeaponType
+
+// "12" from -every=12, or -1 if it isn't a number
+static int parse_count(const std::string& arg, std::size_t at)
+{
+    std::string value = arg.substr(at);
+    if (value.empty() || value.size() > 9 || value.find_first_not_of("0123456789") != std::string::npos)
+        return -1;
+    return std::stoi(value);
+}
+
+int main(int argc, char* argv[])
+{
+    std::string name = "/robotwarz";
+    int every_ms = 200;
+    bool once = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg.find("-every=") == 0)
+        {
+            every_ms = parse_count(arg, 7);
+            if (every_ms <= 0)
+            {
+                std::cerr << "Invalid value for -every. Using 200." << std::endl;
+                every_ms = 200;
+            }
+        }
+        else if (arg == "-once")
+        {
+            once = true;
+        }
+        else if (!arg.empty() && arg[0] != '-')
+        {
+            name = arg[0] == '/' ? arg : "/" + arg;
+        }
+        else
+        {
+            std::cerr << "Unknown argument: " << arg << ". Ignoring it." << std::endl;
+        }
+    }
+
+    // the match may not have started yet
+    std::unique_ptr<SpectatorView> view;
+    while (true)
+    {
+        view = std::make_unique<SpectatorView>(name);
+        if (view->ok() || view->incompatible() || once)
+        {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(every_ms));
+    }
+    if (view->incompatible())
+    {
+        std::cerr << "The match at " << name << " is from a different version of RobotWarz" << std::endl;
+        return 1;
+    }
+    if (!view->ok())
+    {
+        std::cerr << "There's no match at " << name << std::endl;
+        return 1;
+    }
+
+    const int rows = view->rows(), cols = view->cols();
+    const std::vector<SpectatorRobot>& roster = view->roster();
+    SpectatorSnapshot snapshot;
+    std::vector<int> occupant(static_cast<std::size_t>(rows) * cols);
+    std::string out;
+    int shown = -1;
+
+    while (true)
+    {
+        if (view->read(snapshot) && snapshot.round != shown)
+        {
+            // the board only has 'R' and 'X', the stats say whose they are
+            std::fill(occupant.begin(), occupant.end(), -1);
+            for (std::size_t slot = 0; slot < snapshot.stats.size(); ++slot)
+            {
+                const SpectatorStats& stats = snapshot.stats[slot];
+                if (stats.row >= 0 && stats.row < rows && stats.col >= 0 && stats.col < cols)
+                {
+                    occupant[stats.row * cols + stats.col] = static_cast<int>(slot);
+                }
+            }
+
+            out = once ? "" : "\033[H\033[2J";
+            format_board(snapshot.round, rows, cols, snapshot.cells.data(), occupant.data(), cols, out);
+            for (std::size_t slot = 0; slot < roster.size(); ++slot)
+            {
+                const SpectatorStats& stats = snapshot.stats[slot];
+                out += roster[slot].symbol;
+                out += std::string(roster[slot].name) + ":   H: " + std::to_string(stats.health)
+                     + "  W: " + weapon_names[roster[slot].weapon & 3]
+                     + "  A: " + std::to_string(stats.armor) + "  M: " + std::to_string(stats.move)
+                     + "  at: (" + std::to_string(stats.row) + "," + std::to_string(stats.col) + ")"
+                     + (stats.alive ? "" : "  dead") + "\n";
+            }
+            out += std::to_string(snapshot.alive) + " of " + std::to_string(roster.size()) + " still going\n";
+            std::fwrite(out.data(), 1, out.size(), stdout);
+            std::fflush(stdout);
+            shown = snapshot.round;
+        }
+        if (once && shown < 0)
+        {
+            std::cerr << "The match at " << name << " hasn't started yet" << std::endl;
+        }
+        if (once || snapshot.done)
+        {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(every_ms));
+    }
+    return 0;
+}
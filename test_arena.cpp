@@ -23,12 +23,37 @@ int main() {
     //test radar
     tester.test_radar();
     tester.test_radar_local();
+    tester.test_robot_index();
 
     // Test BadRobot with all weapon configurations
     std::cout << "\n=== Testing Weapons ===\n";
     tester.test_handle_shot_with_fake_radar();
     tester.test_robot_with_all_weapons();
     tester.test_grenade_damage();
+    tester.test_railgun_path();
+    tester.test_flame_stencil();
+    tester.test_area_queries();
+    tester.test_board_layers();
+    tester.test_free_runs();
+    tester.test_robot_table();
+    tester.test_turn_events();
+    tester.test_log_sink();
+    tester.test_log_levels();
+    tester.test_compressed_log();
+    tester.test_replay();
+    tester.test_board_renderer();
+    tester.test_live_view();
+    tester.test_viewport();
+    tester.test_frame_export();
+    tester.test_spectator_feed();
+    tester.test_random_streams();
+    tester.test_tournament();
+    tester.test_forked_tournament();
+    tester.test_tournament_daemon();
+    tester.test_match_cache();
+    tester.test_tournament_journal();
+    tester.test_out_of_range_shot();
+    tester.test_radar_footprints();
 
 
     return 0;
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <vector>
 #include <dlfcn.h>
+#include <algorithm>
 
 RobotBase* load_robot(const std::string& shared_lib, void* &handle) 
 {